@@ -0,0 +1,282 @@
+#include <iostream>
+#include <fstream>
+#include <string_view>
+#include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "solver.hpp"
+#include "search_stats.hpp"
+#include "solver_options.hpp"
+#include "puzzles.hpp"
+
+namespace {
+struct BenchOptions {
+    SolverOptions solver;
+    uint32_t nOfRuns = 3;
+    std::string outputPath = "bench.json";
+    // Only puzzles whose name contains filter are run
+    std::string filter;
+    uint32_t maxIterations = 100000000;
+    // Solve with boards looking up their layout at runtime, rather than specialised for each puzzle's BLOCKED tiles
+    bool useRuntimeLayout = false;
+};
+
+// Outcome of a single solve, written by the child process running it back to the driver through a pipe
+struct RunResult {
+    SearchStats stats;
+    uint32_t nOfMoves = 0;
+    double seconds = 0.0;
+    long peakRssKb = 0; // Filled in by the driver from the child's rusage
+};
+
+struct PuzzleResult {
+    std::string name;
+    size_t width;
+    size_t height;
+    std::vector<RunResult> runs;
+    uint32_t nOfFailedRuns = 0;
+};
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--runs <n>] [--output <file>] [--filter <name>] [--heuristic nearest|matching|pdb] [--no-symmetry] [--max-memory <MB> | --partial-expansion] [--runtime-layout]\n"
+              << "  --runs <n>            Solve every puzzle n times (default 3)\n"
+              << "  --output <file>       Write the results as JSON to file (default bench.json)\n"
+              << "  --filter <name>       Only run the puzzles whose name contains name\n"
+              << "  --heuristic <mode>    Heuristic used by the solver, as for the solver binary\n"
+              << "  --no-symmetry         Don't merge mirror images of boards on symmetric puzzles\n"
+              << "  --max-memory <MB>     Bound the memory of the solver\n"
+              << "  --partial-expansion   Only generate the children with the f-cost being expanded (PEA*)\n"
+              << "  --runtime-layout      Don't specialise the solver for the BLOCKED tiles of each puzzle" << std::endl;
+}
+
+template <typename LayoutPolicy, size_t W, size_t H>
+RunResult Solve(const Puzzle<W, H>& puzzle, const BenchOptions& options)
+{
+    Solver<W, H, LayoutPolicy> solver(puzzle, options.solver);
+    auto start = std::chrono::steady_clock::now();
+    auto solution = solver.GenerateSolution(options.maxIterations);
+
+    RunResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stats = solver.Stats();
+    result.nOfMoves = static_cast<uint32_t>(solution.NOfMoves());
+    return result;
+}
+
+// Solves puzzle in a child process, so every run starts from a fresh heap, its peak RSS can be read back from its
+// rusage, and a solver giving up (which exits) only fails that run. Returns std::nullopt if the run failed
+template <typename LayoutPolicy, size_t W, size_t H>
+std::optional<RunResult> RunIsolated(const Puzzle<W, H>& puzzle, const BenchOptions& options)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::cerr << "[Error] Unable to create a pipe to the benchmark process" << std::endl;
+        exit(1);
+    }
+
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "[Error] Unable to fork the benchmark process" << std::endl;
+        exit(1);
+    }
+    if (pid == 0)
+    {
+        // The solvers log their progress to stdout, only errors are kept
+        close(fds[0]);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        RunResult result = Solve<LayoutPolicy>(puzzle, options);
+        bool isSent = write(fds[1], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+        _exit(isSent ? 0 : 1);
+    }
+
+    close(fds[1]);
+    RunResult result;
+    bool isReceived = read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    if (!isReceived || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return std::nullopt;
+
+    result.peakRssKb = usage.ru_maxrss;
+    return result;
+}
+
+double MedianSeconds(const std::vector<RunResult>& runs)
+{
+    std::vector<double> seconds;
+    for (const RunResult& run : runs)
+    {
+        seconds.push_back(run.seconds);
+    }
+    std::sort(seconds.begin(), seconds.end());
+    size_t mid = seconds.size() / 2;
+    return seconds.size() % 2 ? seconds[mid] : (seconds[mid - 1] + seconds[mid]) / 2;
+}
+
+long PeakRssKb(const std::vector<RunResult>& runs)
+{
+    long peak = 0;
+    for (const RunResult& run : runs)
+    {
+        peak = std::max(peak, run.peakRssKb);
+    }
+    return peak;
+}
+
+void PrintSummary(const PuzzleResult& puzzle)
+{
+    if (puzzle.runs.empty())
+    {
+        std::cout << "[Info] " << puzzle.name << ": all " << puzzle.nOfFailedRuns << " runs failed" << std::endl;
+        return;
+    }
+
+    // Searches are deterministic, so the counters of the first run stand for every run
+    const RunResult& first = puzzle.runs.front();
+    double median = MedianSeconds(puzzle.runs);
+    std::cout << "[Info] " << puzzle.name << ": " << first.nOfMoves << " moves, " << first.stats.expandedNodes << " expanded, "
+              << first.stats.generatedNodes << " generated, " << first.stats.filteredNodes << " filtered, median "
+              << median * 1000.0 << "ms (" << static_cast<double>(first.stats.expandedNodes) / median << " nodes/s), peak RSS "
+              << PeakRssKb(puzzle.runs) / 1024 << "MB";
+    if (puzzle.nOfFailedRuns)
+        std::cout << ", " << puzzle.nOfFailedRuns << " failed runs";
+    std::cout << std::endl;
+}
+
+void WriteJson(const std::vector<PuzzleResult>& puzzles, const BenchOptions& options)
+{
+    std::ofstream out(options.outputPath);
+    if (!out)
+    {
+        std::cerr << "[Error] Unable to open " << options.outputPath << " for writing" << std::endl;
+        exit(1);
+    }
+
+    out << "{\n  \"runs\": " << options.nOfRuns << ",\n  \"puzzles\": [";
+    for (size_t i = 0; i < puzzles.size(); i++)
+    {
+        const PuzzleResult& puzzle = puzzles[i];
+        out << (i ? "," : "") << "\n    {\n"
+            << "      \"name\": \"" << puzzle.name << "\",\n"
+            << "      \"width\": " << puzzle.width << ",\n"
+            << "      \"height\": " << puzzle.height << ",\n"
+            << "      \"failedRuns\": " << puzzle.nOfFailedRuns;
+        if (!puzzle.runs.empty())
+        {
+            const RunResult& first = puzzle.runs.front();
+            double median = MedianSeconds(puzzle.runs);
+            out << ",\n"
+                << "      \"moves\": " << first.nOfMoves << ",\n"
+                << "      \"expandedNodes\": " << first.stats.expandedNodes << ",\n"
+                << "      \"generatedNodes\": " << first.stats.generatedNodes << ",\n"
+                << "      \"filteredNodes\": " << first.stats.filteredNodes << ",\n"
+                << "      \"medianSeconds\": " << median << ",\n"
+                << "      \"nodesPerSecond\": " << static_cast<double>(first.stats.expandedNodes) / median << ",\n"
+                << "      \"peakRssKb\": " << PeakRssKb(puzzle.runs) << ",\n"
+                << "      \"seconds\": [";
+            for (size_t run = 0; run < puzzle.runs.size(); run++)
+            {
+                out << (run ? ", " : "") << puzzle.runs[run].seconds;
+            }
+            out << "]";
+        }
+        out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg == "--runs" && i + 1 < argc)
+        {
+            options.nOfRuns = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.outputPath = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "nearest")
+        {
+            options.solver.heuristic = HeuristicMode::NEAREST_TARGET;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "matching")
+        {
+            options.solver.heuristic = HeuristicMode::MATCHING;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "pdb")
+        {
+            options.solver.heuristic = HeuristicMode::PATTERN_DATABASE;
+            i++;
+        }
+        else if (arg == "--no-symmetry")
+        {
+            options.solver.useSymmetry = false;
+        }
+        else if (arg == "--partial-expansion")
+        {
+            options.solver.usePartialExpansion = true;
+            options.maxIterations = UINT32_MAX;
+        }
+        else if (arg == "--runtime-layout")
+        {
+            options.useRuntimeLayout = true;
+        }
+        else if (arg == "--max-memory" && i + 1 < argc)
+        {
+            options.solver.maxMemory = std::stoull(argv[++i]) * 1024 * 1024;
+            options.maxIterations = UINT32_MAX;
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<PuzzleResult> results;
+    Puzzles::ForEachPuzzle([&options, &results]<typename LayoutPolicy, size_t W, size_t H>(const char* name, const Puzzle<W, H>& puzzle) {
+        if (std::string_view(name).find(options.filter) == std::string_view::npos)
+            return;
+
+        PuzzleResult result{name, W, H, {}, 0};
+        for (uint32_t run = 0; run < options.nOfRuns; run++)
+        {
+            auto runResult = options.useRuntimeLayout ? RunIsolated<RuntimeLayout<W, H>>(puzzle, options) : RunIsolated<LayoutPolicy>(puzzle, options);
+            if (runResult)
+                result.runs.push_back(*runResult);
+            else
+                result.nOfFailedRuns++;
+        }
+        PrintSummary(result);
+        results.push_back(std::move(result));
+    });
+
+    WriteJson(results, options);
+    std::cout << "[Info] Wrote results of " << results.size() << " puzzles to " << options.outputPath << std::endl;
+}
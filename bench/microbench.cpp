@@ -0,0 +1,412 @@
+#include <iostream>
+#include <iomanip>
+#include <string_view>
+#include <string>
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "board.hpp"
+#include "solution.hpp"
+#include "node_store.hpp"
+#include "bucket_queue.hpp"
+#include "node_table.hpp"
+#include "symmetry.hpp"
+#include "targets.hpp"
+#include "solver_options.hpp"
+#include "puzzles.hpp"
+
+namespace {
+struct MicrobenchOptions {
+    SolverOptions solver;
+    uint32_t nOfReps = 15;
+    uint32_t nOfWarmupReps = 3;
+    size_t nOfSamples = 4096;
+    bool usePerfCounters = false;
+    // Only kernels whose name contains filter are run
+    std::string filter;
+};
+
+void PrintUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [--reps <n>] [--warmup <n>] [--samples <n>] [--filter <kernel>] [--perf] [--heuristic nearest|matching|pdb]\n"
+              << "  --reps <n>            Measured repetitions of every kernel (default 15)\n"
+              << "  --warmup <n>          Unmeasured repetitions run first (default 3)\n"
+              << "  --samples <n>         Frontier boards each kernel runs over per repetition (default 4096)\n"
+              << "  --filter <kernel>     Only run the kernels whose name contains kernel\n"
+              << "  --perf                Also read hardware counters through perf_event_open (cache and branch misses)\n"
+              << "  --heuristic <mode>    Heuristic the heuristic kernels evaluate, as for the solver binary" << std::endl;
+}
+
+// Keeps the compiler from discarding the result of a kernel
+template <typename T>
+void DoNotOptimise(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Reference cycles from the time-stamp counter, 0 where there is none
+uint64_t ReadCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Hardware counters of the calling thread, read through perf_event_open. Counters the kernel refuses to open (no PMU
+// in a VM, perf_event_paranoid, ...) are reported as unavailable rather than failing the benchmark
+class PerfCounters {
+public:
+    static constexpr size_t kNOfCounters = 4;
+    static constexpr std::array<const char*, kNOfCounters> kNames = {"instructions", "branch-misses", "cache-refs", "cache-misses"};
+    using Values = std::array<std::optional<uint64_t>, kNOfCounters>;
+
+    explicit PerfCounters(bool enabled)
+    {
+        mFds.fill(-1);
+        if (!enabled)
+            return;
+
+        constexpr std::array<uint64_t, kNOfCounters> kConfigs = {PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+        for (size_t i = 0; i < kNOfCounters; i++)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = kConfigs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            mFds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (mFds[i] < 0)
+                std::cerr << "[Warning] Unable to open the " << kNames[i] << " counter (" << std::strerror(errno) << "), it won't be reported" << std::endl;
+        }
+    }
+
+    ~PerfCounters()
+    {
+        for (int fd : mFds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    void Start()
+    {
+        for (int fd : mFds)
+        {
+            if (fd < 0)
+                continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    Values Stop()
+    {
+        Values values;
+        for (size_t i = 0; i < kNOfCounters; i++)
+        {
+            if (mFds[i] < 0)
+                continue;
+            ioctl(mFds[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t value = 0;
+            if (read(mFds[i], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value)))
+                values[i] = value;
+        }
+        return values;
+    }
+
+private:
+    std::array<int, kNOfCounters> mFds;
+};
+
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+// Runs kernel (which performs nOfOps operations per call) for the warm-up and measured repetitions, and prints the
+// median (and fastest) time per operation along with the median cycles and hardware counters per operation
+template <typename Kernel>
+void Measure(const std::string& name, size_t nOfOps, const MicrobenchOptions& options, PerfCounters& counters, Kernel&& kernel)
+{
+    if (name.find(options.filter) == std::string::npos || nOfOps == 0)
+        return;
+
+    for (uint32_t rep = 0; rep < options.nOfWarmupReps; rep++)
+    {
+        kernel();
+    }
+
+    std::vector<double> nsPerOp;
+    std::vector<double> cyclesPerOp;
+    std::array<std::vector<double>, PerfCounters::kNOfCounters> countsPerOp;
+    double ops = static_cast<double>(nOfOps);
+    for (uint32_t rep = 0; rep < options.nOfReps; rep++)
+    {
+        counters.Start();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startCycles = ReadCycleCounter();
+        kernel();
+        uint64_t endCycles = ReadCycleCounter();
+        auto end = std::chrono::steady_clock::now();
+        PerfCounters::Values values = counters.Stop();
+
+        nsPerOp.push_back(std::chrono::duration<double, std::nano>(end - start).count() / ops);
+        cyclesPerOp.push_back(static_cast<double>(endCycles - startCycles) / ops);
+        for (size_t i = 0; i < PerfCounters::kNOfCounters; i++)
+        {
+            if (values[i])
+                countsPerOp[i].push_back(static_cast<double>(*values[i]) / ops);
+        }
+    }
+
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << Median(nsPerOp) << " ns/op (min " << *std::min_element(nsPerOp.begin(), nsPerOp.end())
+              << "), " << std::setw(9) << Median(cyclesPerOp) << " cycles/op";
+    for (size_t i = 0; i < PerfCounters::kNOfCounters; i++)
+    {
+        if (!countsPerOp[i].empty())
+            std::cout << ", " << Median(countsPerOp[i]) << ' ' << PerfCounters::kNames[i] << "/op";
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+// Runs nOfExpansions expansions of A* (as done by Solver, without reopening) and returns a sample of up to nOfSamples
+// nodes spread evenly over what is left in the open list, i.e. the boards the solver would be working on next
+template <typename LayoutPolicy, size_t W, size_t H>
+std::vector<SearchNode<W, H, LayoutPolicy>> SampleFrontier(const Puzzle<W, H>& puzzle, const Targets<W, H>& targets, const Symmetry<W, H>& symmetry,
+                                             size_t nOfExpansions, size_t nOfSamples)
+{
+    using Node = SearchNode<W, H, LayoutPolicy>;
+    NodeStore<W, H, LayoutPolicy> nodes;
+    BucketQueue open;
+    NodeTable seen;
+    auto insert = [&nodes, &open, &seen](const Node& node) {
+        auto isMatch = [&nodes, &node](uint32_t index) { return nodes[index].board == node.board; };
+        auto [entry, inserted] = seen.FindOrInsert(node.board.Hash(), isMatch);
+        if (!inserted)
+            return;
+        uint32_t index = nodes.Add(node);
+        entry->SetOpen(index);
+        open.Push(index, node.GetTotalCost(), node.NOfMoves());
+    };
+
+    Solution<W, H, LayoutPolicy> root(Board<W, H, LayoutPolicy>(puzzle.initialState), targets);
+    insert(NodeStore<W, H, LayoutPolicy>::MakeRoot(root, symmetry));
+    for (size_t i = 0; i < nOfExpansions && !open.empty(); i++)
+    {
+        uint32_t index = open.Pop();
+        for (const Move& move : nodes[index].board.GetPossibleMoves())
+        {
+            insert(nodes.MakeChild(index, move, targets, symmetry));
+        }
+    }
+
+    std::vector<Node> frontier;
+    while (!open.empty())
+    {
+        frontier.push_back(nodes[open.Pop()]);
+    }
+    std::vector<Node> samples;
+    size_t step = std::max<size_t>(1, frontier.size() / nOfSamples);
+    for (size_t i = 0; i < frontier.size() && samples.size() < nOfSamples; i += step)
+    {
+        samples.push_back(frontier[i]);
+    }
+    return samples;
+}
+
+template <typename LayoutPolicy, size_t W, size_t H>
+void RunKernels(const char* name, const Puzzle<W, H>& puzzle, size_t nOfExpansions, const MicrobenchOptions& options, PerfCounters& counters)
+{
+    using Node = SearchNode<W, H, LayoutPolicy>;
+    Targets<W, H> targets(puzzle.TargetMap(), Board<W, H, LayoutPolicy>(puzzle.initialState), options.solver);
+    Symmetry<W, H> symmetry(Board<W, H, LayoutPolicy>(puzzle.initialState).GetLayout(), targets, options.solver.useSymmetry);
+    std::vector<Node> samples = SampleFrontier<LayoutPolicy>(puzzle, targets, symmetry, nOfExpansions, options.nOfSamples);
+
+    // Inputs of the kernels working on a knight or a move rather than a whole board
+    std::vector<std::pair<const Board<W, H, LayoutPolicy>*, BoardPos>> knights;
+    std::vector<Solution<W, H, LayoutPolicy>> solutions;
+    std::vector<Move> firstMoves;
+    for (const Node& node : samples)
+    {
+        for (int8_t y = 0; y < static_cast<int8_t>(H); y++)
+        {
+            for (int8_t x = 0; x < static_cast<int8_t>(W); x++)
+            {
+                BoardState state = node.board.at({x, y});
+                if (state != BoardState::EMPTY && state != BoardState::BLOCKED)
+                    knights.emplace_back(&node.board, BoardPos{x, y});
+            }
+        }
+        auto moves = node.board.GetPossibleMoves();
+        if (moves.empty())
+            continue;
+        solutions.emplace_back(node.board, std::vector<Move>{}, node.heuristicCost);
+        firstMoves.push_back(moves[0]);
+    }
+
+    std::cout << "[Info] " << name << ": " << samples.size() << " boards sampled from the open list after " << nOfExpansions << " expansions" << std::endl;
+    Measure("Board::GetPossibleMoves", samples.size(), options, counters, [&samples] {
+        for (const Node& node : samples)
+        {
+            DoNotOptimise(node.board.GetPossibleMoves().size());
+        }
+    });
+    Measure("std::hash<Board>", samples.size(), options, counters, [&samples] {
+        for (const Node& node : samples)
+        {
+            DoNotOptimise(std::hash<Board<W, H, LayoutPolicy>>{}(node.board));
+        }
+    });
+    Measure("Board::IsSolved", samples.size(), options, counters, [&samples, &targets] {
+        for (const Node& node : samples)
+        {
+            DoNotOptimise(node.board.IsSolved(targets));
+        }
+    });
+    auto solvedPattern = samples.front().board.GetSolvedPattern(targets);
+    Measure("Board::IsSolved (packed pattern)", samples.size(), options, counters, [&samples, &solvedPattern] {
+        for (const Node& node : samples)
+        {
+            DoNotOptimise(Board<W, H, LayoutPolicy>::IsSolved(node.board.GetPackedBoard(), solvedPattern));
+        }
+    });
+    Measure("Board::GetHeuristicCost", samples.size(), options, counters, [&samples, &targets] {
+        for (const Node& node : samples)
+        {
+            DoNotOptimise(node.board.GetHeuristicCost(targets));
+        }
+    });
+    Measure("Board::GetTileHeuristicCost", knights.size(), options, counters, [&knights, &targets] {
+        for (const auto& [board, tile] : knights)
+        {
+            DoNotOptimise(board->GetTileHeuristicCost(tile, targets));
+        }
+    });
+    Measure("Solution::ApplyMove + UndoMove", solutions.size(), options, counters, [&solutions, &firstMoves, &targets] {
+        for (size_t i = 0; i < solutions.size(); i++)
+        {
+            solutions[i].ApplyMove(Move(firstMoves[i]), targets);
+            solutions[i].UndoMove(targets);
+        }
+        DoNotOptimise(solutions.back().heuristicCost);
+    });
+    Measure("Symmetry::Canonicalise", samples.size(), options, counters, [&samples, &symmetry] {
+        for (const Node& node : samples)
+        {
+            Board<W, H, LayoutPolicy> board = node.board;
+            DoNotOptimise(symmetry.Canonicalise(board));
+        }
+    });
+    // Solver's open list and closed set, standing in for the old Solver::NodeOrder comparator
+    Measure("BucketQueue::Push + Pop", samples.size(), options, counters, [&samples] {
+        BucketQueue queue;
+        for (uint32_t i = 0; i < samples.size(); i++)
+        {
+            queue.Push(i, samples[i].GetTotalCost(), samples[i].NOfMoves());
+        }
+        while (!queue.empty())
+        {
+            DoNotOptimise(queue.Pop());
+        }
+    });
+    Measure("NodeTable::FindOrInsert + Find", samples.size(), options, counters, [&samples] {
+        NodeTable table;
+        auto insertOrFind = [&table, &samples](uint32_t i) {
+            auto isMatch = [&samples, i](uint32_t index) { return samples[index].board == samples[i].board; };
+            auto [entry, inserted] = table.FindOrInsert(samples[i].board.Hash(), isMatch);
+            if (inserted)
+                entry->SetOpen(i);
+        };
+        for (uint32_t i = 0; i < samples.size(); i++)
+        {
+            insertOrFind(i);
+        }
+        for (uint32_t i = 0; i < samples.size(); i++)
+        {
+            auto isMatch = [&samples, i](uint32_t index) { return samples[index].board == samples[i].board; };
+            DoNotOptimise(table.Find(samples[i].board.Hash(), isMatch));
+        }
+    });
+}
+}
+
+int main(int argc, char* argv[])
+{
+    MicrobenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg == "--reps" && i + 1 < argc)
+        {
+            options.nOfReps = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        }
+        else if (arg == "--warmup" && i + 1 < argc)
+        {
+            options.nOfWarmupReps = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--samples" && i + 1 < argc)
+        {
+            options.nOfSamples = std::max<size_t>(1, std::stoull(argv[++i]));
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--perf")
+        {
+            options.usePerfCounters = true;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "nearest")
+        {
+            options.solver.heuristic = HeuristicMode::NEAREST_TARGET;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "matching")
+        {
+            options.solver.heuristic = HeuristicMode::MATCHING;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "pdb")
+        {
+            options.solver.heuristic = HeuristicMode::PATTERN_DATABASE;
+            i++;
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    PerfCounters counters(options.usePerfCounters);
+    // Queen_A1 is solved after ~300 expansions, King_E1 after ~3.5M, sample both well into the search. Both are run
+    // with boards looking up their layout at runtime, and with boards specialised for the puzzle's BLOCKED tiles
+    RunKernels<RuntimeLayout<4, 5>>("Queen_A1", Puzzles::Queen_A1, 200, options, counters);
+    RunKernels<Puzzles::StaticLayoutOf<Puzzles::Queen_A1>>("Queen_A1 (static layout)", Puzzles::Queen_A1, 200, options, counters);
+    RunKernels<RuntimeLayout<5, 5>>("King_E1", Puzzles::King_E1, 200000, options, counters);
+    RunKernels<Puzzles::StaticLayoutOf<Puzzles::King_E1>>("King_E1 (static layout)", Puzzles::King_E1, 200000, options, counters);
+}
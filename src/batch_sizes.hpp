@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <sstream>
+
+#include "batch_solver.hpp"
+#include "solver.hpp"
+
+template <size_t W, size_t H>
+BatchResult SolveBatchPuzzle(Puzzle<W, H>&& puzzle, const SolverOptions& options)
+{
+    auto start = std::chrono::steady_clock::now();
+    Solver solver(puzzle, options);
+    // Memory-bounded and partial expansion searches trade memory for re-expansions, so don't cap their iterations
+    auto solution = solver.TrySolve(options.maxMemory || options.usePartialExpansion ? UINT32_MAX : 10000000);
+
+    BatchResult result;
+    result.width = W;
+    result.height = H;
+    result.isSolved = solution.has_value();
+    result.expandedNodes = solver.Stats().expandedNodes;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!solution)
+    {
+        result.details = solver.FailureReason();
+        return result;
+    }
+
+    std::ostringstream moves;
+    for (size_t i = 0; i < solution->moves.size(); i++)
+    {
+        moves << (i ? ", " : "") << solution->moves[i];
+    }
+    result.nOfMoves = solution->NOfMoves();
+    result.details = moves.str();
+    return result;
+}
+
+// Instantiates SolveBatchPuzzle for every height of a board width
+#define INSTANTIATE_SOLVE_BATCH_PUZZLE(W)                                                               \
+    template BatchResult SolveBatchPuzzle<W, 1>(Puzzle<W, 1>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 2>(Puzzle<W, 2>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 3>(Puzzle<W, 3>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 4>(Puzzle<W, 4>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 5>(Puzzle<W, 5>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 6>(Puzzle<W, 6>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 7>(Puzzle<W, 7>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 8>(Puzzle<W, 8>&& puzzle, const SolverOptions& options);  \
+    template BatchResult SolveBatchPuzzle<W, 9>(Puzzle<W, 9>&& puzzle, const SolverOptions& options);
+
+static_assert(MAX_BOARD_SIZE == 9, "INSTANTIATE_SOLVE_BATCH_PUZZLE and src/batch_sizes/ cover boards up to 9x9");
@@ -0,0 +1,3 @@
+#include "batch_sizes.hpp"
+
+INSTANTIATE_SOLVE_BATCH_PUZZLE(5)
@@ -0,0 +1,89 @@
+#include "batch_solver.hpp"
+
+#include <chrono>
+#include <iostream>
+
+#include "puzzle_dispatch.hpp"
+#include "puzzle_file.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace {
+// Puzzles read ahead of the workers, per worker
+constexpr size_t kPendingPuzzlesPerThread = 4;
+
+std::string JsonEscape(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+}
+
+BatchSolver::BatchSolver(const SolverOptions& options, const std::string& outputPath)
+    : mOptions(options), mOutputPath(outputPath), mOutput(outputPath)
+{
+    if (!mOutput)
+    {
+        std::cerr << "[Error] Unable to open " << outputPath << " for writing" << std::endl;
+        exit(1);
+    }
+    // Every puzzle's solver would otherwise log its progress to the same stdout
+    mOptions.isQuiet = true;
+}
+
+size_t BatchSolver::Run(const std::string& puzzlePath)
+{
+    PuzzleReader reader(puzzlePath);
+    WorkStealingPool pool(mOptions.nOfThreads);
+    std::cout << "[Info] Solving the puzzles of " << puzzlePath << " on " << pool.size() << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t nOfPuzzles = 0;
+    while (std::optional<PuzzleDescription> description = reader.Next())
+    {
+        pool.WaitForPending(kPendingPuzzlesPerThread * pool.size());
+        pool.Submit([this, index = nOfPuzzles, description = std::move(*description)] {
+            BatchResult result = DispatchPuzzle(description, [this]<size_t W, size_t H>(Puzzle<W, H>&& puzzle) {
+                return SolveBatchPuzzle(std::move(puzzle), mOptions);
+            });
+            result.index = index;
+            result.name = description.name;
+            Write(result);
+        });
+        nOfPuzzles++;
+    }
+    pool.WaitForPending(0);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Info] Solved " << mNOfSolved << " of " << nOfPuzzles << " puzzles in " << seconds << "s, results written to " << mOutputPath << std::endl;
+    return mNOfFailed;
+}
+
+void BatchSolver::Write(const BatchResult& result)
+{
+    std::lock_guard<std::mutex> lock(mOutputMutex);
+    mOutput << "{\"index\":" << result.index << ",\"name\":\"" << JsonEscape(result.name) << "\",\"width\":" << result.width
+            << ",\"height\":" << result.height << ",\"solved\":" << (result.isSolved ? "true" : "false");
+    if (result.isSolved)
+        mOutput << ",\"moves\":" << result.nOfMoves;
+    mOutput << ",\"expandedNodes\":" << result.expandedNodes << ",\"seconds\":" << result.seconds << ","
+            << (result.isSolved ? "\"solution\":\"" : "\"failure\":\"") << JsonEscape(result.details) << "\"}\n";
+    // Flushed per result, so the output can be followed while the batch runs
+    mOutput.flush();
+
+    if (result.isSolved)
+    {
+        mNOfSolved++;
+        std::cout << "[Info] " << result.name << ": " << result.nOfMoves << " moves in " << result.seconds << "s" << std::endl;
+    }
+    else
+    {
+        mNOfFailed++;
+        std::cerr << "[Warning] " << result.name << ": " << result.details << std::endl;
+    }
+}
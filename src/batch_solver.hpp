@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "puzzles.hpp"
+#include "solver_options.hpp"
+
+// Outcome of solving one puzzle of a batch
+struct BatchResult {
+    size_t index = 0; // Position of the puzzle in its file
+    std::string name;
+    size_t width = 0;
+    size_t height = 0;
+    bool isSolved = false;
+    uint32_t nOfMoves = 0;
+    uint64_t expandedNodes = 0;
+    double seconds = 0.0;
+    // Moves of the solution, or why there is none
+    std::string details;
+};
+
+// Solves puzzle with the default A* solver without exiting on failure. Compiling the solver for all
+// MAX_BOARD_SIZE x MAX_BOARD_SIZE sizes takes minutes, so it's defined in batch_sizes.hpp and instantiated one width
+// per translation unit (src/batch_sizes/), letting make build them in parallel
+template <size_t W, size_t H>
+BatchResult SolveBatchPuzzle(Puzzle<W, H>&& puzzle, const SolverOptions& options);
+
+// Solves every puzzle of a puzzle file (see PuzzleReader), options.nOfThreads puzzles at a time on a
+// WorkStealingPool. Puzzles are read as the pool catches up rather than all up front, and each result is written to
+// the output as a JSON line as soon as its puzzle is done, so results come out in completion order (the "index" field
+// gives the position of the puzzle in the file)
+class BatchSolver {
+public:
+    BatchSolver(const SolverOptions& options, const std::string& outputPath);
+
+    // Returns the number of puzzles which couldn't be solved
+    size_t Run(const std::string& puzzlePath);
+
+private:
+    void Write(const BatchResult& result);
+
+    SolverOptions mOptions;
+    std::string mOutputPath;
+    std::ofstream mOutput;
+    std::mutex mOutputMutex;
+    size_t mNOfSolved = 0;
+    size_t mNOfFailed = 0;
+};
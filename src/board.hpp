@@ -10,13 +10,17 @@
 #include <type_traits>
 #include <optional>
 #include <algorithm>
+#include <bit>
+#include <utility>
 
 #include "common.hpp"
 #include "enum_value_map.hpp"
 #include "helper.hpp"
+#include "board_layout.hpp"
+#include "move_list.hpp"
+#include "targets.hpp"
 
-static constexpr size_t MAX_BOARD_SIZE = 9;
-static constexpr uint32_t TOTAL_HASH_BITS = 8 * sizeof(size_t);  
+static constexpr uint32_t PACKED_WORD_BITS = 8 * sizeof(uint64_t);
 
 enum class BoardState : uint8_t { // Ensures smallest possible size is used for enum
     EMPTY,
@@ -28,37 +32,112 @@ enum class BoardState : uint8_t { // Ensures smallest possible size is used for
 
 std::ostream& operator<<(std::ostream& os, BoardState boardState);
 
-template <size_t Width, size_t Height> requires (Width <= MAX_BOARD_SIZE && Height <= MAX_BOARD_SIZE)
+// Zobrist keys for every (slot, tile state) pair of a packed board. EMPTY tiles have a key of 0, so the hash of an
+// empty board is 0 and moving a knight only touches the keys of its start and end slots
+template <size_t Slots>
+inline constexpr auto kZobristKeys = [] {
+    std::array<std::array<uint64_t, 4>, Slots> keys{};
+    for (size_t slot = 0; slot < Slots; slot++)
+    {
+        for (size_t state = 1; state < keys[slot].size(); state++)
+        {
+            keys[slot][state] = Helpers::MixHash((slot << 2 | state) + 0x9e3779b97f4a7c15ULL);
+        }
+    }
+    return keys;
+}();
+
+template <size_t Width, size_t Height, typename LayoutPolicy> requires (Width <= MAX_BOARD_SIZE && Height <= MAX_BOARD_SIZE)
 class Board {
 public:
     Board(const std::array<std::array<char, Width>, Height>& refBoard);
 
+    static constexpr uint32_t kBoardStateBitWidth = Helpers::ceillog2(static_cast<int>(BoardState::BLOCKED) - 1);  
+    static constexpr uint32_t kSlotsPerWord = PACKED_WORD_BITS / kBoardStateBitWidth;
+    static constexpr size_t kPackedWords = (Width * Height + kSlotsPerWord - 1) / kSlotsPerWord;
+    using PackedBoard = std::array<uint64_t, kPackedWords>;
+    // Every move starts on a knight and ends on an EMPTY tile, each with at most 8 knight moves, so there are never
+    // more than 8 * min(# of knights, # of EMPTY tiles) moves
+    static constexpr size_t kMaxMoves = knightMoves.size() * (Width * Height / 2);
+    using Moves = MoveList<kMaxMoves>;
+    // Boards spanning several packed words keep a Zobrist hash of their tiles up to date as they change. A board
+    // fitting in a single word is its own (perfect) hash, so it doesn't pay for the extra member
+    static constexpr bool kCachesHash = kPackedWords > 1;
+
+    // Rebuilds a board from its packed representation (e.g. as stored on disk by ExternalSolver)
+    Board(const BoardLayout<Width, Height>& layout, const PackedBoard& packed);
+    // Same, for a board whose Hash is already known, which spares recomputing it
+    Board(const BoardLayout<Width, Height>& layout, const PackedBoard& packed, uint64_t hash);
+
+    // Tiles under mask which hold exactly tiles on every solved board (a knight of the target's colour on each target),
+    // letting solutions be recognised from the packed board alone
+    struct SolvedPattern {
+        PackedBoard mask;
+        PackedBoard tiles;
+    };
+
     constexpr int8_t width() const { return Width; }
     constexpr int8_t height() const { return Height; }
-    BoardState at(const BoardPos& bp) const { return mBoard[bp.y][bp.x]; }
-    const std::array<std::array<BoardState, Width>, Height>& GetBoard() const { return mBoard; }
-    bool operator==(const Board<Width, Height>& other) const { return mBoard == other.GetBoard(); }
+    BoardState at(const BoardPos& bp) const;
+    const PackedBoard& GetPackedBoard() const { return mPacked; }
+    uint64_t Hash() const;
+    const BoardLayout<Width, Height>& GetLayout() const { return mLayout.Get(); }
+    bool operator==(const Board& other) const { return mPacked == other.mPacked; }
     
-    bool IsSolved(const std::unordered_map<Target, std::vector<BoardPos>>& targets) const;
-    uint32_t GetTileHeuristicCost(const BoardPos& tile, const std::unordered_map<Target, std::vector<BoardPos>>& targets) const;
-    uint32_t GetHeuristicCost(const std::unordered_map<Target, std::vector<BoardPos>>& targets) const;
-
+    bool IsSolved(const Targets<Width, Height>& targets) const;
+    SolvedPattern GetSolvedPattern(const Targets<Width, Height>& targets) const;
+    static bool IsSolved(const PackedBoard& packed, const SolvedPattern& pattern);
+    // Returns true if the board provably can't be solved. Knights never leave their component of the knight-move
+    // graph (see BoardLayout::componentOf), so each component needs at least as many knights of each colour as it has
+    // targets of that colour, and a component without EMPTY tiles can never change. Moves keep both true, so a board
+    // is dead exactly when the boards it's reached from are
+    bool IsDead(const Targets<Width, Height>& targets) const;
+    // Returns the part of the heuristic cost which depends on the knight on tile, i.e. the part which can change when it moves
+    uint32_t GetTileHeuristicCost(const BoardPos& tile, const Targets<Width, Height>& targets) const;
+    uint32_t GetHeuristicCost(const Targets<Width, Height>& targets) const;
+    // Returns the fewest moves needed to fill every target of a colour with a distinct knight of that colour
+    uint32_t GetMatchingCost(Target target, const Targets<Width, Height>& targets) const;
+    // Sum of the per-colour costs (pattern database or matching) of every colour, which
+    // GetTileHeuristicCost/GetHeuristicCost leave out in PATTERN_DATABASE mode
+    uint32_t GetColourHeuristicCost(const Targets<Width, Height>& targets) const;
+
+    // Calls func(slot, isOfColour) for every slot of the packed board holding a knight, in increasing order.
+    // isOfColour is true for the knights matching target
+    template <typename Func>
+    void ForEachKnight(Target target, Func&& func) const;
+
+    // Moves are only validated in DEBUG builds, moves coming from outside of the solvers should be checked with IsMoveValid
     void ApplyMove(const Move& move);
-    std::vector<Move> GetPossibleMoves() const;
-
-    static constexpr uint32_t kBoardStateBitWidth = Helpers::ceillog2(static_cast<int>(BoardState::BLOCKED) - 1);  
-    static constexpr bool kHashOverflowPossible = kBoardStateBitWidth * Width * Height > TOTAL_HASH_BITS;
+    bool IsMoveValid(const Move& move, bool enableLogging = false) const;
+    Moves GetPossibleMoves() const;
+    // Returns a copy of the board with the tile in each slot moved to slotMap[slot] (see Symmetry)
+    Board PermuteSlots(const std::array<uint8_t, Width * Height>& slotMap) const;
 
-    template<size_t W, size_t H>
-    friend std::ostream& operator<<(std::ostream& os, const Board<W, H>& b);
+    template<size_t W, size_t H, typename L>
+    friend std::ostream& operator<<(std::ostream& os, const Board<W, H, L>& b);
 
 private:
-    BoardState& operator[](const BoardPos& bp) { return mBoard[bp.y][bp.x]; }
+    using Layout = BoardLayout<Width, Height>;
+
+    static constexpr uint64_t kSlotMask = (uint64_t{1} << kBoardStateBitWidth) - 1;
+
+    BoardState GetSlot(size_t slot) const;
+    BoardPos SlotPos(size_t slot) const { return {static_cast<int8_t>(GetLayout().cellOf[slot] % Width), static_cast<int8_t>(GetLayout().cellOf[slot] / Width)}; }
+    void SetSlot(size_t slot, BoardState state);
+    void Set(const BoardPos& bp, BoardState state) { SetSlot(static_cast<size_t>(GetLayout().slotOf[Layout::CellIndex(bp.x, bp.y)]), state); }
 
     constexpr bool IsInBounds(const BoardPos& pos) const;
-    bool IsMoveValid(const Move& move, bool enableLogging = false) const;
+    // GetPossibleMoves over the constant move table of a StaticLayout, without any loop or branch
+    template <size_t... Indices>
+    Moves GetPossibleMovesUnrolled(std::index_sequence<Indices...>) const;
+
+    struct NoHash {};
 
-    std::array<std::array<BoardState, Width>, Height> mBoard;
+    // Only the mutable tiles are stored, kBoardStateBitWidth bits each, in the slot order given by mLayout (which
+    // takes no space with a StaticLayout)
+    [[no_unique_address]] LayoutPolicy mLayout;
+    PackedBoard mPacked;
+    [[no_unique_address]] std::conditional_t<kCachesHash, uint64_t, NoHash> mHash{};
 };
 
 // Templated functions must be defined in the same translation unit they are declared, implementation is below
@@ -71,26 +150,143 @@ static constexpr auto boardStateMapping = EnumValueMap<BoardState, char, static_
     {BoardState::BLOCKED, 'X'}}
 }};
 
-std::ostream& operator<<(std::ostream& os, BoardState boardState)
+inline std::ostream& operator<<(std::ostream& os, BoardState boardState)
 {
     os << boardStateMapping.toValue(boardState);
     return os;
 }
 
+// BLOCKED tiles of a board given as characters (as in Puzzle::initialState)
 template <size_t Width, size_t Height>
-Board<Width, Height>::Board(const std::array<std::array<char, Width>, Height>& refBoard)
+constexpr BlockedMask<Width, Height> BlockedTilesOf(const std::array<std::array<char, Width>, Height>& refBoard)
 {
+    BlockedMask<Width, Height> blocked{};
     for (size_t y = 0; y < Height; y++)
     {
         for (size_t x = 0; x < Width; x++)
         {
-            mBoard[y][x] = boardStateMapping.toEnum(refBoard[y][x]);
+            blocked[y * Width + x] = boardStateMapping.toEnum(refBoard[y][x]) == BoardState::BLOCKED;
+        }
+    }
+    return blocked;
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+Board<Width, Height, LayoutPolicy>::Board(const std::array<std::array<char, Width>, Height>& refBoard)
+    : mLayout(LayoutPolicy::Of(BlockedTilesOf(refBoard))), mPacked{}
+{
+    for (size_t slot = 0; slot < GetLayout().nOfSlots; slot++)
+    {
+        size_t cell = GetLayout().cellOf[slot];
+        SetSlot(slot, boardStateMapping.toEnum(refBoard[cell / Width][cell % Width]));
+    }
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+Board<Width, Height, LayoutPolicy>::Board(const BoardLayout<Width, Height>& layout, const PackedBoard& packed)
+    : mLayout(layout), mPacked{}
+{
+    if constexpr (kCachesHash)
+    {
+        // Goes through SetSlot so the cached hash is computed along the way
+        Board source = *this;
+        source.mPacked = packed;
+        for (size_t slot = 0; slot < GetLayout().nOfSlots; slot++)
+        {
+            SetSlot(slot, source.GetSlot(slot));
+        }
+    }
+    else
+    {
+        mPacked = packed;
+    }
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+Board<Width, Height, LayoutPolicy>::Board(const BoardLayout<Width, Height>& layout, const PackedBoard& packed, [[maybe_unused]] uint64_t hash)
+    : mLayout(layout), mPacked(packed)
+{
+    if constexpr (kCachesHash)
+        mHash = hash;
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+BoardState Board<Width, Height, LayoutPolicy>::at(const BoardPos& bp) const
+{
+    int8_t slot = GetLayout().slotOf[Layout::CellIndex(bp.x, bp.y)];
+    if (slot == Layout::kNoSlot)
+        return BoardState::BLOCKED;
+    return GetSlot(static_cast<size_t>(slot));
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+BoardState Board<Width, Height, LayoutPolicy>::GetSlot(size_t slot) const
+{
+    uint64_t word = mPacked[slot / kSlotsPerWord];
+    return static_cast<BoardState>((word >> ((slot % kSlotsPerWord) * kBoardStateBitWidth)) & kSlotMask);
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+template <typename Func>
+void Board<Width, Height, LayoutPolicy>::ForEachKnight(Target target, Func&& func) const
+{
+    static_assert(kBoardStateBitWidth == 2, "ForEachKnight assumes 2-bit tiles");
+    static constexpr uint64_t kLowBits = 0x5555555555555555ULL;
+    BoardState knight = target == Target::BLUE ? BoardState::BLUE : BoardState::RED;
+    uint64_t pattern = static_cast<uint64_t>(knight) * kLowBits;
+    for (size_t i = 0; i < kPackedWords; i++)
+    {
+        // EMPTY is 00 and tiles matching the knight are 00 after the XOR, so both masks can be collected in the low
+        // bit of each tile. Unused slots hold EMPTY, so they are never visited
+        uint64_t word = mPacked[i];
+        uint64_t diff = word ^ pattern;
+        uint64_t occupied = (word | (word >> 1)) & kLowBits;
+        uint64_t matches = ~(diff | (diff >> 1)) & kLowBits;
+        while (occupied)
+        {
+            int bit = std::countr_zero(occupied);
+            func(i * kSlotsPerWord + static_cast<size_t>(bit) / kBoardStateBitWidth, static_cast<bool>((matches >> bit) & 1));
+            occupied &= occupied - 1;
         }
     }
 }
 
+template <size_t Width, size_t Height, typename LayoutPolicy>
+uint64_t Board<Width, Height, LayoutPolicy>::Hash() const
+{
+    // BLOCKED tiles are not part of the packed board, so a single packed word is already a unique hash
+    if constexpr (kCachesHash)
+        return mHash;
+    else
+        return mPacked[0];
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+Board<Width, Height, LayoutPolicy> Board<Width, Height, LayoutPolicy>::PermuteSlots(const std::array<uint8_t, Width * Height>& slotMap) const
+{
+    Board permuted = *this;
+    permuted.mPacked.fill(0);
+    permuted.mHash = {};
+    for (size_t slot = 0; slot < GetLayout().nOfSlots; slot++)
+    {
+        permuted.SetSlot(slotMap[slot], GetSlot(slot));
+    }
+    return permuted;
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+void Board<Width, Height, LayoutPolicy>::SetSlot(size_t slot, BoardState state)
+{
+    if constexpr (kCachesHash)
+        mHash ^= kZobristKeys<Width * Height>[slot][static_cast<size_t>(GetSlot(slot))] ^ kZobristKeys<Width * Height>[slot][static_cast<size_t>(state)];
+
+    uint64_t& word = mPacked[slot / kSlotsPerWord];
+    size_t shift = (slot % kSlotsPerWord) * kBoardStateBitWidth;
+    word = (word & ~(kSlotMask << shift)) | (static_cast<uint64_t>(state) << shift);
+}
+
 namespace {
-std::optional<Target> GetCorrespondingTarget(BoardState boardState)
+inline std::optional<Target> GetCorrespondingTarget(BoardState boardState)
 {
     switch (boardState) 
     {
@@ -107,15 +303,15 @@ std::optional<Target> GetCorrespondingTarget(BoardState boardState)
     exit(1);
 }
 
-bool boardStateMatchesTarget(BoardState boardState, Target target) 
+inline bool boardStateMatchesTarget(BoardState boardState, Target target)
 {
     auto boardStateTarget = GetCorrespondingTarget(boardState);
     return boardStateTarget && boardStateTarget.value() == target;
 }
 }
 
-template <size_t Width, size_t Height>
-bool Board<Width, Height>::IsSolved(const std::unordered_map<Target, std::vector<BoardPos>>& targets) const
+template <size_t Width, size_t Height, typename LayoutPolicy>
+bool Board<Width, Height, LayoutPolicy>::IsSolved(const Targets<Width, Height>& targets) const
 {
     for (const auto& [target, positions] : targets)
     {
@@ -128,63 +324,208 @@ bool Board<Width, Height>::IsSolved(const std::unordered_map<Target, std::vector
     return true;
 }
 
-template <size_t W, size_t H>
-uint32_t Board<W, H>::GetTileHeuristicCost(const BoardPos& tile, const std::unordered_map<Target, std::vector<BoardPos>>& targets) const
+template <size_t W, size_t H, typename L>
+typename Board<W, H, L>::SolvedPattern Board<W, H, L>::GetSolvedPattern(const Targets<W, H>& targets) const
 {
-    auto target = GetCorrespondingTarget(this->at(tile));
-    if (!target)
-        return 0;
+    SolvedPattern pattern{};
+    for (const auto& [target, positions] : targets)
+    {
+        BoardState knight = target == Target::BLUE ? BoardState::BLUE : BoardState::RED;
+        for (const auto& pos : positions)
+        {
+            // Targets never lie on BLOCKED tiles (see Targets::Targets), so every one has a slot
+            int8_t slot = GetLayout().slotOf[Layout::CellIndex(pos.x, pos.y)];
+            size_t word = static_cast<size_t>(slot) / kSlotsPerWord;
+            size_t shift = (static_cast<size_t>(slot) % kSlotsPerWord) * kBoardStateBitWidth;
+            pattern.mask[word] |= kSlotMask << shift;
+            pattern.tiles[word] |= static_cast<uint64_t>(knight) << shift;
+        }
+    }
+    return pattern;
+}
 
-    const auto& candidateDestinations = targets.at(target.value());
-    auto cmp = [tile](BoardPos end1, BoardPos end2) { return Helpers::MinimumMovesToDestination(tile, end1) < Helpers::MinimumMovesToDestination(tile, end2); };
-    auto minIt = std::min_element(candidateDestinations.begin(), candidateDestinations.end(), cmp);
-    return Helpers::MinimumMovesToDestination(tile, *minIt);
+template <size_t W, size_t H, typename L>
+bool Board<W, H, L>::IsSolved(const PackedBoard& packed, const SolvedPattern& pattern)
+{
+    uint64_t mismatches = 0;
+    for (size_t i = 0; i < kPackedWords; i++)
+    {
+        mismatches |= (packed[i] & pattern.mask[i]) ^ pattern.tiles[i];
+    }
+    return mismatches == 0;
 }
 
-template <size_t W, size_t H>
-uint32_t Board<W, H>::GetHeuristicCost(const std::unordered_map<Target, std::vector<BoardPos>>& targets) const
+template <size_t W, size_t H, typename L>
+bool Board<W, H, L>::IsDead(const Targets<W, H>& targets) const
 {
-    uint32_t minimumMovesToSolve = 0;
-    // Minimum moves to get pieces to target
-    for (int8_t y = 0; y < height(); y++)
+    const Layout& layout = GetLayout();
+    // Per component: knights minus targets of each colour, EMPTY tiles, and whether a target still needs a knight
+    std::array<std::array<int32_t, Targets<W, H>::kNOfTargets>, Layout::kCells> surplus{};
+    std::array<uint32_t, Layout::kCells> nOfEmpty{};
+    std::array<bool, Layout::kCells> isUnsolved{};
+    for (size_t slot = 0; slot < layout.nOfSlots; slot++)
+    {
+        BoardState state = GetSlot(slot);
+        if (state == BoardState::EMPTY)
+            nOfEmpty[layout.componentOf[slot]]++;
+        if (auto target = GetCorrespondingTarget(state))
+            surplus[layout.componentOf[slot]][static_cast<size_t>(*target)]++;
+    }
+    for (const auto& [target, positions] : targets)
     {
-        for (int8_t x = 0; x < width(); x++)
+        for (const auto& pos : positions)
         {
-            BoardPos start{x, y};
-            minimumMovesToSolve += GetTileHeuristicCost(start, targets);
+            int8_t slot = layout.slotOf[Layout::CellIndex(pos.x, pos.y)];
+            uint8_t component = layout.componentOf[static_cast<size_t>(slot)];
+            surplus[component][static_cast<size_t>(target)]--;
+            isUnsolved[component] |= !boardStateMatchesTarget(GetSlot(static_cast<size_t>(slot)), target);
         }
     }
 
-    // Minimum moves to get pieces out of the way for target
-    for (auto& [_, tiles] : targets)
+    for (size_t component = 0; component < layout.nOfComponents; component++)
     {
-        for (auto tile : tiles)
+        if (isUnsolved[component] && nOfEmpty[component] == 0)
+            return true;
+        for (int32_t knights : surplus[component])
         {
-            minimumMovesToSolve += this->at(tile) == BoardState::YELLOW;
+            if (knights < 0)
+                return true;
         }
     }
+    return false;
+}
+
+template <size_t W, size_t H, typename L>
+uint32_t Board<W, H, L>::GetTileHeuristicCost(const BoardPos& tile, const Targets<W, H>& targets) const
+{
+    BoardState state = this->at(tile);
+    // Yellow knights never need to reach a target, but have to move at least once to get out of the way of one
+    if (state == BoardState::YELLOW)
+        return targets.IsTarget(tile);
+
+    auto target = GetCorrespondingTarget(state);
+    if (!target)
+        return 0;
+
+    switch (targets.Mode())
+    {
+        case HeuristicMode::NEAREST_TARGET:
+            return targets.MinimumMovesToTarget(target.value(), tile);
+        case HeuristicMode::MATCHING:
+            return GetMatchingCost(target.value(), targets);
+        case HeuristicMode::PATTERN_DATABASE:
+            // Pattern database costs depend on every knight, so they're left to GetColourHeuristicCost
+            return 0;
+    }
+    std::cerr << "Unexpected heuristic mode " << static_cast<int>(targets.Mode()) << std::endl;
+    exit(1);
+}
 
+template <size_t W, size_t H, typename L>
+uint32_t Board<W, H, L>::GetHeuristicCost(const Targets<W, H>& targets) const
+{
+    // Matching and pattern database costs are shared by all knights of a colour, so they're added once below
+    bool isPerColour = targets.Mode() != HeuristicMode::NEAREST_TARGET;
+    uint32_t minimumMovesToSolve = 0;
+    // BLOCKED tiles cost nothing, so only the slots of the layout are visited (a constant count with a StaticLayout)
+    for (size_t slot = 0; slot < GetLayout().nOfSlots; slot++)
+    {
+        if (isPerColour && GetCorrespondingTarget(GetSlot(slot)))
+            continue;
+        minimumMovesToSolve += GetTileHeuristicCost(SlotPos(slot), targets);
+    }
+
+    if (isPerColour)
+        minimumMovesToSolve += GetColourHeuristicCost(targets);
     return minimumMovesToSolve;
 }
 
-template <size_t Width, size_t Height>
-void Board<Width, Height>::ApplyMove(const Move& move)
+template <size_t W, size_t H, typename L>
+uint32_t Board<W, H, L>::GetColourHeuristicCost(const Targets<W, H>& targets) const
 {
+    uint32_t cost = 0;
+    for (size_t i = 0; i < Targets<W, H>::kNOfTargets; i++)
+    {
+        Target target = static_cast<Target>(i);
+        // Colours without a pattern database (too large to build) fall back to the matching heuristic
+        auto patternCost = targets.Mode() == HeuristicMode::PATTERN_DATABASE ? targets.GetPatternCost(target, *this) : std::nullopt;
+        cost += patternCost ? patternCost.value() : GetMatchingCost(target, targets);
+    }
+    return cost;
+}
+
+template <size_t W, size_t H, typename L>
+uint32_t Board<W, H, L>::GetMatchingCost(Target target, const Targets<W, H>& targets) const
+{
+    size_t nOfTargets = targets.NOfTargets(target);
+    if (nOfTargets == 0)
+        return 0;
+
+    // Bounded so the DP below stays cheap, larger puzzles fall back to charging each knight its nearest target
+    static constexpr size_t kMaxMatchedTargets = 10;
+    if (nOfTargets > kMaxMatchedTargets)
+    {
+        uint32_t cost = 0;
+        ForEachKnight(target, [&](size_t slot, bool isOfColour) {
+            if (isOfColour)
+                cost += targets.MinimumMovesToTarget(target, SlotPos(slot));
+        });
+        return cost;
+    }
+
+    // minCost[mask] = cheapest assignment of the knights seen so far to the set of targets in mask. Masks are visited
+    // in decreasing order so each knight is assigned to at most one target
+    static constexpr uint32_t kNoAssignment = UINT32_MAX;
+    std::array<uint32_t, size_t{1} << kMaxMatchedTargets> minCost;
+    size_t fullMask = (size_t{1} << nOfTargets) - 1;
+    std::fill(minCost.begin(), minCost.begin() + static_cast<std::ptrdiff_t>(fullMask + 1), kNoAssignment);
+    minCost[0] = 0;
+    ForEachKnight(target, [&](size_t slot, bool isOfColour) {
+        if (!isOfColour)
+            return;
+
+        BoardPos tile = SlotPos(slot);
+        for (size_t mask = fullMask; mask-- > 0;)
+        {
+            if (minCost[mask] == kNoAssignment)
+                continue;
+            for (size_t i = 0; i < nOfTargets; i++)
+            {
+                uint8_t moves = targets.MinimumMovesToTarget(target, i, tile);
+                if ((mask >> i) & 1 || moves == Targets<W, H>::kUnreachable)
+                    continue;
+                uint32_t& assigned = minCost[mask | (size_t{1} << i)];
+                assigned = std::min(assigned, minCost[mask] + moves);
+            }
+        }
+    });
+
+    // Not enough knights can reach the targets, the board can't be solved
+    if (minCost[fullMask] == kNoAssignment)
+        return Targets<W, H>::kUnreachable;
+    return minCost[fullMask];
+}
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+void Board<Width, Height, LayoutPolicy>::ApplyMove(const Move& move)
+{
+#ifdef DEBUG
     if (!IsMoveValid(move, true))
         exit(1);
-    
-    (*this)[move.end] = (*this)[move.start];
-    (*this)[move.start] = BoardState::EMPTY;
+#endif
+
+    Set(move.end, this->at(move.start));
+    Set(move.start, BoardState::EMPTY);
 }
 
-template <size_t Width, size_t Height>
-constexpr bool Board<Width, Height>::IsInBounds(const BoardPos& pos) const
+template <size_t Width, size_t Height, typename LayoutPolicy>
+constexpr bool Board<Width, Height, LayoutPolicy>::IsInBounds(const BoardPos& pos) const
 {
     return pos.x >= 0 && pos.x < width() && pos.y >= 0 && pos.y < height();
 }
 
 namespace {
-bool IsKnight(BoardState state)
+constexpr bool IsKnight(BoardState state)
 {
     return (state == BoardState::BLUE 
             || state == BoardState::RED 
@@ -192,8 +533,8 @@ bool IsKnight(BoardState state)
 }
 }
 
-template <size_t Width, size_t Height>
-bool Board<Width, Height>::IsMoveValid(const Move& move, bool enableLogging) const
+template <size_t Width, size_t Height, typename LayoutPolicy>
+bool Board<Width, Height, LayoutPolicy>::IsMoveValid(const Move& move, bool enableLogging) const
 {
     if (!IsInBounds(move.start) || !IsInBounds(move.end))
     {
@@ -229,32 +570,92 @@ bool Board<Width, Height>::IsMoveValid(const Move& move, bool enableLogging) con
     return true;
 }
 
-template <size_t Width, size_t Height>
-std::vector<Move> Board<Width, Height>::GetPossibleMoves() const
-{
-    std::vector<Move> moves;
-    for (int8_t y = 0; y < height(); y++)
-    {
-        for (int8_t x = 0; x < width(); x++)
+// Every knight move between two slots of a static layout, in the order GetPossibleMoves finds them at runtime
+template <size_t Width, typename LayoutPolicy>
+struct SlotMoves {
+    struct Entry {
+        uint8_t start;
+        uint8_t end;
+        Move move;
+    };
+
+    static constexpr auto& kLayout = LayoutPolicy::kLayout;
+    static constexpr size_t kCount = [] {
+        size_t count = 0;
+        for (size_t slot = 0; slot < kLayout.nOfSlots; slot++)
+        {
+            count += kLayout.nOfSlotNeighbours[slot];
+        }
+        return count;
+    }();
+    static constexpr auto kEntries = [] {
+        std::array<Entry, kCount> entries{};
+        size_t count = 0;
+        for (size_t slot = 0; slot < kLayout.nOfSlots; slot++)
         {
-            BoardPos start = {x, y};
-            if (IsKnight(this->at(start)))
+            for (size_t i = 0; i < kLayout.nOfSlotNeighbours[slot]; i++)
             {
-                for (BoardPos displacement : knightMoves)
-                {
-                    Move candidate {start, start + displacement};
-                    if (IsMoveValid(candidate))
-                        moves.push_back(std::move(candidate));
-                }
+                size_t start = kLayout.cellOf[slot];
+                size_t end = kLayout.cellOf[kLayout.slotNeighbours[slot][i]];
+                entries[count++] = {static_cast<uint8_t>(slot), kLayout.slotNeighbours[slot][i], Move{
+                    {static_cast<int8_t>(start % Width), static_cast<int8_t>(start / Width)},
+                    {static_cast<int8_t>(end % Width), static_cast<int8_t>(end / Width)}
+                }};
             }
         }
+        return entries;
+    }();
+};
+
+template <size_t Width, size_t Height, typename LayoutPolicy>
+typename Board<Width, Height, LayoutPolicy>::Moves Board<Width, Height, LayoutPolicy>::GetPossibleMoves() const
+{
+    if constexpr (LayoutPolicy::kIsStatic)
+        return GetPossibleMovesUnrolled(std::make_index_sequence<SlotMoves<Width, LayoutPolicy>::kCount>{});
+
+    // Every non-EMPTY slot holds a knight (BLOCKED tiles aren't stored), and the layout's neighbour table already
+    // leaves out moves off the board or onto BLOCKED tiles
+    const Layout& layout = GetLayout();
+    Moves moves;
+    for (size_t slot = 0; slot < layout.nOfSlots; slot++)
+    {
+        if (GetSlot(slot) == BoardState::EMPTY)
+            continue;
+
+        BoardPos start = SlotPos(slot);
+        for (size_t i = 0; i < layout.nOfSlotNeighbours[slot]; i++)
+        {
+            uint8_t neighbour = layout.slotNeighbours[slot][i];
+            if (GetSlot(neighbour) == BoardState::EMPTY)
+                moves.push_back({start, SlotPos(neighbour)});
+        }
     }
+    return moves;
+}
 
+template <size_t Width, size_t Height, typename LayoutPolicy>
+template <size_t... Indices>
+typename Board<Width, Height, LayoutPolicy>::Moves Board<Width, Height, LayoutPolicy>::GetPossibleMovesUnrolled(std::index_sequence<Indices...>) const
+{
+    static_assert(kBoardStateBitWidth == 2, "GetPossibleMovesUnrolled assumes 2-bit tiles");
+    static constexpr uint64_t kLowBits = 0x5555555555555555ULL;
+    constexpr const auto& entries = SlotMoves<Width, LayoutPolicy>::kEntries;
+    // Low bit of every tile holding a knight, as in ForEachKnight
+    PackedBoard occupied;
+    for (size_t i = 0; i < kPackedWords; i++)
+    {
+        occupied[i] = (mPacked[i] | (mPacked[i] >> 1)) & kLowBits;
+    }
+    auto isOccupied = [&occupied](size_t slot) { return occupied[slot / kSlotsPerWord] >> ((slot % kSlotsPerWord) * kBoardStateBitWidth); };
+
+    // Each move is written out, and only counted if it starts on a knight and ends on an EMPTY tile
+    Moves moves;
+    (moves.PushBackIf(entries[Indices].move, (isOccupied(entries[Indices].start) & ~isOccupied(entries[Indices].end) & 1) != 0), ...);
     return moves;
 }
 
 namespace {
-std::string GenerateRowSeperator(size_t width)
+inline std::string GenerateRowSeperator(size_t width)
 {
     size_t sepLength = width * 2 + 2;
     std::string rowSeperator;
@@ -271,7 +672,7 @@ std::string GenerateRowSeperator(size_t width)
     return rowSeperator;
 }
 
-std::string GenerateRowHeader(int8_t width)
+inline std::string GenerateRowHeader(int8_t width)
 {
     size_t headerLength = 2 * width + 1;
     std::string rowHeader;
@@ -286,20 +687,23 @@ std::string GenerateRowHeader(int8_t width)
 }
 }
 
-template <size_t Width, size_t Height>
-std::ostream& operator<<(std::ostream& os, const Board<Width, Height>& b)
+template <size_t Width, size_t Height, typename LayoutPolicy>
+std::ostream& operator<<(std::ostream& os, const Board<Width, Height, LayoutPolicy>& b)
 {
     static const std::string rowHeader{GenerateRowHeader(b.width())};
     static const std::string rowSeperator{GenerateRowSeperator(Width)};
 
     os << rowHeader << '\n';
 
+    // Slots are numbered in cell order, so they're read in turn rather than looked up for every tile
+    const BoardLayout<Width, Height>& layout = b.GetLayout();
+    size_t slot = 0;
     for (int8_t y = 0; y < b.height(); y++)
     {
         os << rowSeperator << '\n' << y+1;
         for (int8_t x = 0; x < b.width(); x++)
         {
-            os << '|' << b.at({x, y});
+            os << '|' << (layout.blocked[BoardLayout<Width, Height>::CellIndex(x, y)] ? BoardState::BLOCKED : b.GetSlot(slot++));
         }
         os << "|\n";
     }
@@ -309,40 +713,12 @@ std::ostream& operator<<(std::ostream& os, const Board<Width, Height>& b)
 }
 
 namespace std {
-    template <size_t Width, size_t Height>
-    struct hash<Board<Width, Height>>
+    template <size_t Width, size_t Height, typename LayoutPolicy>
+    struct hash<Board<Width, Height, LayoutPolicy>>
     {
-        std::size_t operator()(const Board<Width, Height>& b) const
+        std::size_t operator()(const Board<Width, Height, LayoutPolicy>& b) const
         {
-            size_t boardHash = 0;
-            size_t temp = 0;
-            int tempBitsUsed = 0;
-
-            for (int8_t y = 0; y < b.height(); y++) 
-            {
-                for (int8_t x = 0; x < b.width(); x++)
-                {
-                    BoardState s = b.at({x, y});
-                    // The blocked board state is not included in the hash since it tiles with this state are constant
-                    if (s != BoardState::BLOCKED)
-                    {
-                        temp <<= Board<Width, Height>::kBoardStateBitWidth;
-                        temp += static_cast<uint32_t>(s);
-                        tempBitsUsed += Board<Width, Height>::kBoardStateBitWidth;
-                    }
-
-                    // Check if there's enough space for the next tile
-                    if constexpr (Board<Width, Height>::kHashOverflowPossible) {
-                        if (tempBitsUsed + Board<Width, Height>::kBoardStateBitWidth > TOTAL_HASH_BITS) 
-                        {
-                            boardHash ^= temp;
-                            temp = 0;
-                            tempBitsUsed = 0;
-                        }
-                    }
-                }
-            }
-            return boardHash ^ temp;
+            return static_cast<size_t>(b.Hash());
         }
     };
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "common.hpp"
+
+static constexpr size_t MAX_BOARD_SIZE = 9;
+
+// Knight-move neighbours of every cell (indexed y * Width + x) of an empty Width x Height board
+template <size_t Width, size_t Height>
+struct KnightNeighbours {
+    static constexpr size_t kCells = Width * Height;
+
+    std::array<std::array<uint8_t, knightMoves.size()>, kCells> cells{};
+    std::array<uint8_t, kCells> count{};
+
+    constexpr KnightNeighbours()
+    {
+        for (size_t cell = 0; cell < kCells; cell++)
+        {
+            for (const BoardPos& displacement : knightMoves)
+            {
+                int x = static_cast<int>(cell % Width) + displacement.x;
+                int y = static_cast<int>(cell / Width) + displacement.y;
+                if (x < 0 || x >= static_cast<int>(Width) || y < 0 || y >= static_cast<int>(Height))
+                    continue;
+                cells[cell][count[cell]++] = static_cast<uint8_t>(static_cast<size_t>(y) * Width + static_cast<size_t>(x));
+            }
+        }
+    }
+};
+
+template <size_t Width, size_t Height>
+inline constexpr KnightNeighbours<Width, Height> kKnightNeighbours{};
+
+// Describes which tiles of a board are BLOCKED, and how the remaining (mutable) tiles are laid out in a packed board.
+// BLOCKED tiles never change during a solve, so they are stored once per puzzle layout rather than once per board.
+template <size_t Width, size_t Height>
+struct BoardLayout {
+    static constexpr size_t kCells = Width * Height;
+    static constexpr int8_t kNoSlot = -1;
+
+    std::array<bool, kCells> blocked;
+    std::array<int8_t, kCells> slotOf;  // cell index -> slot index in the packed board (kNoSlot if BLOCKED)
+    std::array<uint8_t, kCells> cellOf; // slot index -> cell index
+    uint8_t nOfSlots;
+    // Knight-move neighbours of every slot, leaving out BLOCKED tiles
+    std::array<std::array<uint8_t, knightMoves.size()>, kCells> slotNeighbours;
+    std::array<uint8_t, kCells> nOfSlotNeighbours;
+    // Connected components of the knight-move graph over slots. Knights never leave the component they start in
+    std::array<uint8_t, kCells> componentOf; // slot index -> component index
+    uint8_t nOfComponents;
+
+    static constexpr size_t CellIndex(int8_t x, int8_t y) { return static_cast<size_t>(y) * Width + static_cast<size_t>(x); }
+
+    // Returns a layout shared by every board with the same set of BLOCKED tiles. Layouts live for the remainder of
+    // the program, so boards can safely hold on to a raw pointer to them.
+    static const BoardLayout* Intern(const std::array<bool, kCells>& blocked);
+
+    constexpr explicit BoardLayout(const std::array<bool, kCells>& blocked);
+};
+
+template <size_t W, size_t H>
+constexpr BoardLayout<W, H>::BoardLayout(const std::array<bool, kCells>& blockedTiles)
+    : blocked(blockedTiles), slotOf{}, cellOf{}, nOfSlots(0), slotNeighbours{}, nOfSlotNeighbours{}, componentOf{}, nOfComponents(0)
+{
+    for (size_t cell = 0; cell < kCells; cell++)
+    {
+        if (blocked[cell])
+        {
+            slotOf[cell] = kNoSlot;
+            continue;
+        }
+        slotOf[cell] = static_cast<int8_t>(nOfSlots);
+        cellOf[nOfSlots++] = static_cast<uint8_t>(cell);
+    }
+
+    constexpr const KnightNeighbours<W, H>& neighbours = kKnightNeighbours<W, H>;
+    for (size_t slot = 0; slot < nOfSlots; slot++)
+    {
+        size_t cell = cellOf[slot];
+        for (size_t i = 0; i < neighbours.count[cell]; i++)
+        {
+            int8_t neighbour = slotOf[neighbours.cells[cell][i]];
+            if (neighbour != kNoSlot)
+                slotNeighbours[slot][nOfSlotNeighbours[slot]++] = static_cast<uint8_t>(neighbour);
+        }
+    }
+
+    constexpr uint8_t kNoComponent = UINT8_MAX;
+    componentOf.fill(kNoComponent);
+    std::array<uint8_t, kCells> stack{};
+    for (size_t root = 0; root < nOfSlots; root++)
+    {
+        if (componentOf[root] != kNoComponent)
+            continue;
+
+        size_t stackSize = 0;
+        componentOf[root] = nOfComponents;
+        stack[stackSize++] = static_cast<uint8_t>(root);
+        while (stackSize > 0)
+        {
+            uint8_t slot = stack[--stackSize];
+            for (size_t i = 0; i < nOfSlotNeighbours[slot]; i++)
+            {
+                uint8_t neighbour = slotNeighbours[slot][i];
+                if (componentOf[neighbour] != kNoComponent)
+                    continue;
+                componentOf[neighbour] = nOfComponents;
+                stack[stackSize++] = neighbour;
+            }
+        }
+        nOfComponents++;
+    }
+}
+
+template <size_t W, size_t H>
+const BoardLayout<W, H>* BoardLayout<W, H>::Intern(const std::array<bool, kCells>& blocked)
+{
+    static std::mutex layoutsMutex;
+    static std::map<std::array<bool, kCells>, std::unique_ptr<const BoardLayout>> layouts;
+
+    std::lock_guard<std::mutex> lock(layoutsMutex);
+    auto& layout = layouts[blocked];
+    if (!layout)
+        layout.reset(new BoardLayout(blocked));
+    return layout.get();
+}
+
+// BLOCKED tiles of a board, indexed by cell
+template <size_t Width, size_t Height>
+using BlockedMask = std::array<bool, Width * Height>;
+
+// Layout policies of a Board, deciding where its BoardLayout comes from. RuntimeLayout points to a layout interned
+// when the board is built, so one Board type handles any set of BLOCKED tiles at the cost of a pointer per board
+template <size_t Width, size_t Height>
+class RuntimeLayout {
+public:
+    static constexpr bool kIsStatic = false;
+
+    static RuntimeLayout Of(const BlockedMask<Width, Height>& blocked) { return RuntimeLayout(*BoardLayout<Width, Height>::Intern(blocked)); }
+    explicit RuntimeLayout(const BoardLayout<Width, Height>& layout) : mLayout(&layout) {}
+
+    const BoardLayout<Width, Height>& Get() const { return *mLayout; }
+
+private:
+    const BoardLayout<Width, Height>* mLayout;
+};
+
+// StaticLayout fixes the BLOCKED tiles at compile time (see Puzzles::StaticLayoutOf): boards store nothing, and every
+// lookup in the layout is a constant the compiler can fold, which lets Board unroll its loops over slots
+template <size_t Width, size_t Height, BlockedMask<Width, Height> Blocked>
+class StaticLayout {
+public:
+    static constexpr bool kIsStatic = true;
+    static constexpr BoardLayout<Width, Height> kLayout{Blocked};
+
+    static StaticLayout Of(const BlockedMask<Width, Height>& blocked)
+    {
+        if (blocked != Blocked)
+        {
+            std::cerr << "[Error] Board doesn't match the BLOCKED tiles of its static layout" << std::endl;
+            exit(1);
+        }
+        return StaticLayout();
+    }
+    StaticLayout() = default;
+    explicit StaticLayout(const BoardLayout<Width, Height>&) {}
+
+    static constexpr const BoardLayout<Width, Height>& Get() { return kLayout; }
+};
+
+template <size_t Width, size_t Height, typename LayoutPolicy = RuntimeLayout<Width, Height>> requires (Width <= MAX_BOARD_SIZE && Height <= MAX_BOARD_SIZE)
+class Board;
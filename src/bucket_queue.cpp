@@ -0,0 +1,170 @@
+#include "bucket_queue.hpp"
+
+#include <cassert>
+
+void BucketQueue::Push(uint32_t handle, uint32_t f, uint32_t g)
+{
+    if (f >= mBuckets.size())
+    {
+        mBuckets.resize(f + 1);
+        mLayerSizes.resize(f + 1, 0);
+    }
+    auto& layer = mBuckets[f];
+    if (g >= layer.size())
+        layer.resize(g + 1);
+
+    PushHandle(layer[g], handle);
+    mLayerSizes[f]++;
+    mSize++;
+    if (f < mMinF || mSize == 1)
+        mMinF = f;
+}
+
+uint32_t BucketQueue::MinCost()
+{
+    assert(!empty());
+    while (mLayerSizes[mMinF] == 0)
+        mMinF++;
+    return mMinF;
+}
+
+uint32_t BucketQueue::Pop()
+{
+    auto& layer = mBuckets[MinCost()];
+    for (size_t g = layer.size(); g-- > 0;)
+    {
+        if (layer[g].empty())
+            continue;
+
+        uint32_t handle = PopHandle(layer[g]);
+        mLayerSizes[mMinF]--;
+        mSize--;
+        return handle;
+    }
+    // mLayerSizes[mMinF] != 0 guarantees one of the buckets is non-empty
+    __builtin_unreachable();
+}
+
+uint32_t BucketQueue::PopWorst()
+{
+    uint32_t maxF = MaxCost();
+    auto& layer = mBuckets[maxF];
+    for (size_t g = 0; g < layer.size(); g++)
+    {
+        if (layer[g].empty())
+            continue;
+
+        uint32_t handle = PopHandle(layer[g]);
+        mLayerSizes[maxF]--;
+        mSize--;
+        return handle;
+    }
+    // mLayerSizes[maxF] != 0 guarantees one of the buckets is non-empty
+    __builtin_unreachable();
+}
+
+uint32_t BucketQueue::MaxCost() const
+{
+    assert(!empty());
+    // Costs are bounded by the length of a solution, so scanning down from the top layer is cheap
+    size_t f = mLayerSizes.size() - 1;
+    while (mLayerSizes[f] == 0)
+        f--;
+    return static_cast<uint32_t>(f);
+}
+
+size_t BucketQueue::BytesUsed() const
+{
+    size_t bytes = mBuckets.capacity() * sizeof(mBuckets[0]) + mLayerSizes.capacity() * sizeof(size_t);
+    for (const auto& layer : mBuckets)
+    {
+        bytes += layer.capacity() * sizeof(Bucket);
+    }
+    return bytes + mBlocks.BytesUsed() + mFreeBlocks.capacity() * sizeof(uint32_t);
+}
+
+void BucketQueue::PushHandle(Bucket& bucket, uint32_t handle)
+{
+    if (bucket.empty() || mBlocks[bucket.top].size == kBlockHandles)
+    {
+        uint32_t block;
+        if (!mFreeBlocks.empty())
+        {
+            block = mFreeBlocks.back();
+            mFreeBlocks.pop_back();
+        }
+        else
+        {
+            block = static_cast<uint32_t>(mBlocks.size());
+            mBlocks.push_back({});
+        }
+        mBlocks[block].below = bucket.top;
+        mBlocks[block].size = 0;
+        bucket.top = block;
+    }
+    Block& top = mBlocks[bucket.top];
+    top.handles[top.size++] = handle;
+}
+
+uint32_t BucketQueue::PopHandle(Bucket& bucket)
+{
+    Block& top = mBlocks[bucket.top];
+    uint32_t handle = top.handles[--top.size];
+    if (top.size == 0)
+    {
+        mFreeBlocks.push_back(bucket.top);
+        bucket.top = top.below;
+    }
+    return handle;
+}
+
+void BucketQueue::Save(CheckpointWriter& writer) const
+{
+    writer.WriteValue<uint64_t>(mBuckets.size());
+    for (const auto& layer : mBuckets)
+    {
+        writer.WriteValue<uint64_t>(layer.size());
+        for (const Bucket& bucket : layer)
+        {
+            // Written bottom to top, so pushing them back in order rebuilds the bucket
+            std::vector<uint32_t> blocks;
+            for (uint32_t block = bucket.top; block != kNoBlock; block = mBlocks[block].below)
+            {
+                blocks.push_back(block);
+            }
+            std::vector<uint32_t> handles;
+            for (auto it = blocks.rbegin(); it != blocks.rend(); it++)
+            {
+                handles.insert(handles.end(), mBlocks[*it].handles, mBlocks[*it].handles + mBlocks[*it].size);
+            }
+            writer.WriteVector(handles);
+        }
+    }
+}
+
+void BucketQueue::Load(CheckpointReader& reader)
+{
+    mBuckets.clear();
+    mBlocks.clear();
+    mFreeBlocks.clear();
+    mBuckets.resize(reader.ReadValue<uint64_t>());
+    mLayerSizes.assign(mBuckets.size(), 0);
+    mSize = 0;
+    std::vector<uint32_t> handles;
+    for (size_t f = 0; f < mBuckets.size(); f++)
+    {
+        mBuckets[f].resize(reader.ReadValue<uint64_t>());
+        for (Bucket& bucket : mBuckets[f])
+        {
+            reader.ReadVector(handles);
+            for (uint32_t handle : handles)
+            {
+                PushHandle(bucket, handle);
+            }
+            mLayerSizes[f] += handles.size();
+            mSize += handles.size();
+        }
+    }
+    // MinCost scans up to the lowest non-empty layer
+    mMinF = 0;
+}
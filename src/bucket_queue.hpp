@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "checkpoint.hpp"
+#include "slab_array.hpp"
+
+// Priority queue over small integer costs, using one bucket per (f, g) pair. Pops return the entry with the lowest
+// f-cost, breaking ties by preferring the highest g-cost (deepest node), and are LIFO within a bucket.
+// Push and pop are O(1) (amortised, costs are bounded by the length of a solution).
+//
+// Entries can't be removed once pushed: to decrease a key, push the handle again with its new costs and have the
+// owner discard the stale entry when it is popped (see Solver::GetNextNode).
+//
+// Buckets are stacks of fixed-size blocks taken from a pool shared by every bucket. Blocks emptied by pops go back to
+// the pool for any bucket to reuse, whereas the capacity of a vector per bucket would stay allocated once drained.
+class BucketQueue {
+public:
+    void Push(uint32_t handle, uint32_t f, uint32_t g);
+    uint32_t Pop();
+    // Returns the lowest f-cost in the queue, which must not be empty
+    uint32_t MinCost();
+    // Pops the entry with the highest f-cost, breaking ties by preferring the lowest g-cost (shallowest node). Used to
+    // pick the nodes to forget when a search runs out of memory (see Solver::PruneNodes)
+    uint32_t PopWorst();
+    // Returns the highest f-cost in the queue, which must not be empty
+    uint32_t MaxCost() const;
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+    size_t BytesUsed() const;
+    // Blocks allocated by the pool, and how many of them are free
+    size_t NOfBlocks() const { return mBlocks.size(); }
+    size_t NOfFreeBlocks() const { return mFreeBlocks.size(); }
+
+    // Saves the entries (stale ones included) in bucket order, so a loaded queue pops them in the same order
+    void Save(CheckpointWriter& writer) const;
+    void Load(CheckpointReader& reader);
+
+private:
+    static constexpr uint32_t kNoBlock = UINT32_MAX;
+    // Sized so a block is 1KB
+    static constexpr size_t kBlockHandles = 254;
+
+    struct Block {
+        uint32_t below; // Next block down the stack of the bucket, kNoBlock at the bottom
+        uint32_t size;
+        uint32_t handles[kBlockHandles];
+    };
+
+    struct Bucket {
+        uint32_t top = kNoBlock;
+
+        bool empty() const { return top == kNoBlock; }
+    };
+
+    void PushHandle(Bucket& bucket, uint32_t handle);
+    uint32_t PopHandle(Bucket& bucket);
+
+    // mBuckets[f][g] holds the handles pushed with costs (f, g)
+    std::vector<std::vector<Bucket>> mBuckets;
+    SlabArray<Block, 10> mBlocks;
+    std::vector<uint32_t> mFreeBlocks;
+    std::vector<size_t> mLayerSizes;
+    uint32_t mMinF = 0;
+    size_t mSize = 0;
+};
@@ -0,0 +1,150 @@
+#include "checkpoint.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/wait.h>
+
+namespace {
+// Checkpoints are written and read through stdio with buffers of this many bytes
+constexpr size_t kBufferBytes = size_t{1} << 20;
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void RequestStop(int)
+{
+    stopRequested = 1;
+}
+
+uint64_t NowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path)
+    : mPath(path), mTempPath(path + ".tmp"), mFile(std::fopen(mTempPath.c_str(), "wb"))
+{
+    if (!mFile)
+    {
+        std::cerr << "[Error] Unable to open " << mTempPath << " for writing" << std::endl;
+        exit(1);
+    }
+    std::setvbuf(mFile, nullptr, _IOFBF, kBufferBytes);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    if (mFile)
+        std::fclose(mFile);
+}
+
+void CheckpointWriter::Write(const void* data, size_t size)
+{
+    if (size && std::fwrite(data, 1, size, mFile) != size)
+    {
+        std::cerr << "[Error] Unable to write to " << mTempPath << " (out of disk space?)" << std::endl;
+        exit(1);
+    }
+}
+
+void CheckpointWriter::Commit()
+{
+    bool isWritten = std::fflush(mFile) == 0 && fsync(fileno(mFile)) == 0;
+    isWritten = std::fclose(mFile) == 0 && isWritten;
+    mFile = nullptr;
+    if (!isWritten || std::rename(mTempPath.c_str(), mPath.c_str()) != 0)
+    {
+        std::cerr << "[Error] Unable to write checkpoint to " << mPath << std::endl;
+        exit(1);
+    }
+}
+
+CheckpointReader::CheckpointReader(const std::string& path)
+    : mPath(path), mFile(std::fopen(path.c_str(), "rb"))
+{
+    if (!mFile)
+    {
+        std::cerr << "[Error] Unable to open checkpoint " << mPath << " for reading" << std::endl;
+        exit(1);
+    }
+    std::setvbuf(mFile, nullptr, _IOFBF, kBufferBytes);
+}
+
+CheckpointReader::~CheckpointReader()
+{
+    std::fclose(mFile);
+}
+
+void CheckpointReader::Read(void* data, size_t size)
+{
+    if (size && std::fread(data, 1, size, mFile) != size)
+    {
+        std::cerr << "[Error] Checkpoint " << mPath << " is truncated" << std::endl;
+        exit(1);
+    }
+}
+
+CheckpointScheduler::CheckpointScheduler(const std::string& path, uint32_t intervalSeconds)
+    : mPath(path), mIntervalNs(uint64_t{intervalSeconds} * 1000000000), mLastStartNs(NowNs())
+{}
+
+CheckpointScheduler::~CheckpointScheduler()
+{
+    Reap(true);
+}
+
+bool CheckpointScheduler::IsDue()
+{
+    return NowNs() - mLastStartNs >= mIntervalNs && Reap(false);
+}
+
+void CheckpointScheduler::InstallStopHandler()
+{
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+}
+
+bool CheckpointScheduler::IsStopRequested()
+{
+    return stopRequested;
+}
+
+bool CheckpointScheduler::Reap(bool wait)
+{
+    if (mChild < 0)
+        return true;
+
+    int status = 0;
+    pid_t reaped = waitpid(mChild, &status, wait ? 0 : WNOHANG);
+    if (reaped == 0)
+        return false;
+    if (reaped < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        std::cerr << "[Warning] Writing checkpoint to " << mPath << " failed, keeping the previous one" << std::endl;
+    mChild = -1;
+    return true;
+}
+
+pid_t CheckpointScheduler::Fork()
+{
+    // Anything buffered would otherwise be written by both processes
+    std::cout.flush();
+    std::cerr.flush();
+    auto start = NowNs();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "[Warning] Unable to fork to write a checkpoint, skipping it" << std::endl;
+        mLastStartNs = start;
+        return pid;
+    }
+    if (pid > 0)
+    {
+        mChild = pid;
+        mLastStartNs = start;
+        std::cout << "[Info] Writing checkpoint to " << mPath << " in process " << pid << " (forking took " << (NowNs() - start) / 1000 << "us)\n";
+    }
+    return pid;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Binary writer for search checkpoints. The checkpoint is written to a temporary file which Commit moves over path,
+// so a checkpoint already at path is only ever replaced by a complete one
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const std::string& path);
+    ~CheckpointWriter();
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void Write(const void* data, size_t size);
+    template <typename T>
+    void WriteValue(const T& value);
+    // Writes the number of elements followed by the elements themselves
+    template <typename T>
+    void WriteVector(const std::vector<T>& values);
+
+    // Syncs the file to disk and renames it to path
+    void Commit();
+
+private:
+    std::string mPath;
+    std::string mTempPath;
+    std::FILE* mFile;
+};
+
+// Reads back the fields written by a CheckpointWriter, in the same order
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const std::string& path);
+    ~CheckpointReader();
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+    void Read(void* data, size_t size);
+    template <typename T>
+    T ReadValue();
+    template <typename T>
+    void ReadVector(std::vector<T>& values);
+
+    const std::string& path() const { return mPath; }
+
+private:
+    std::string mPath;
+    std::FILE* mFile;
+};
+
+// Writes checkpoints from a forked child process: the child gets a copy-on-write snapshot of the search as it was at
+// the fork, so the search only pauses for the fork itself while the snapshot is written out
+class CheckpointScheduler {
+public:
+    CheckpointScheduler(const std::string& path, uint32_t intervalSeconds);
+    // Waits for a checkpoint still being written, so it isn't left half-written
+    ~CheckpointScheduler();
+    CheckpointScheduler(const CheckpointScheduler&) = delete;
+    CheckpointScheduler& operator=(const CheckpointScheduler&) = delete;
+
+    // Returns true if the interval has elapsed since the last checkpoint was started and none is being written
+    bool IsDue();
+    // Forks and has the child call write(CheckpointWriter&) before exiting, the parent returns straight away
+    template <typename Func>
+    void Start(Func&& write);
+    // Writes a checkpoint in this process, waiting for any checkpoint being written in the background first
+    template <typename Func>
+    void WriteNow(Func&& write);
+
+    // SIGINT and SIGTERM set a flag (see IsStopRequested) instead of killing the process, so the search can write a
+    // last checkpoint before exiting
+    static void InstallStopHandler();
+    static bool IsStopRequested();
+
+private:
+    // Reaps the child writing a checkpoint, blocking if wait is set. Returns false if it is still running
+    bool Reap(bool wait);
+    pid_t Fork();
+
+    std::string mPath;
+    uint64_t mIntervalNs;
+    uint64_t mLastStartNs;
+    pid_t mChild = -1;
+};
+
+template <typename T>
+void CheckpointWriter::WriteValue(const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    Write(&value, sizeof(T));
+}
+
+template <typename T>
+void CheckpointWriter::WriteVector(const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    WriteValue<uint64_t>(values.size());
+    Write(values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+T CheckpointReader::ReadValue()
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    Read(&value, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void CheckpointReader::ReadVector(std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    values.resize(ReadValue<uint64_t>());
+    Read(values.data(), values.size() * sizeof(T));
+}
+
+template <typename Func>
+void CheckpointScheduler::Start(Func&& write)
+{
+    if (Fork() != 0)
+        return;
+
+    CheckpointWriter writer(mPath);
+    write(writer);
+    writer.Commit();
+    // Skips the destructors and atexit handlers of the parent's state, which the child only has a copy of
+    _exit(0);
+}
+
+template <typename Func>
+void CheckpointScheduler::WriteNow(Func&& write)
+{
+    Reap(true);
+    CheckpointWriter writer(mPath);
+    write(writer);
+    writer.Commit();
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <queue>
+#include <filesystem>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "solution.hpp"
+#include "node_store.hpp"
+#include "symmetry.hpp"
+#include "record_file.hpp"
+#include "puzzles.hpp"
+#include "solver_options.hpp"
+
+// External-memory A* solver, for puzzles whose search doesn't fit in RAM. The open and closed lists live on disk,
+// partitioned into buckets of fixed-size records by (g, h). Buckets are expanded in order of f = g + h (then g) in a
+// streaming pass: the bucket's open file is sorted externally (sorted runs of at most
+// SolverOptions::externalSortRecords records, then a k-way merge), and duplicates are removed by merging it against
+// the sorted closed files of the buckets the same board could have been reached in before. Since every move can be
+// undone, a board first reached with g moves can only be reached again with g + 1 or g + 2 moves, so the buckets
+// (g - 1, h) and (g - 2, h) are enough (along with (g, h) itself, in case it's reopened). Memory usage is bounded
+// by the sort buffer and the I/O buffers of the buckets being written to.
+//
+// Records don't store a parent pointer, the parent of a board is rebuilt by undoing its last move, and then looked
+// up in the closed files (which are sorted) by binary search to continue reconstructing the solution.
+template <size_t Width, size_t Height>
+class ExternalSolver
+{
+public:
+    ExternalSolver(const Puzzle<Width, Height>& puzzle, const SolverOptions& options = {});
+    ~ExternalSolver();
+
+    Solution<Width, Height> GenerateSolution(uint64_t maxIterations = 100000000);
+
+private:
+    using Node = SearchNode<Width, Height>;
+    using PackedBoard = typename Board<Width, Height>::PackedBoard;
+    // Buckets are indexed by (g, h)
+    using BucketKey = std::pair<uint32_t, uint32_t>;
+
+    struct Record {
+        PackedBoard board;
+        Move lastMove;
+        uint8_t symmetry;
+
+        bool operator<(const Record& other) const { return board < other.board; }
+    };
+
+    struct Bucket {
+        std::unique_ptr<RecordWriter> open;
+        std::string openPath;
+        // Every file is sorted and free of duplicates, and no board appears in more than one of them
+        std::vector<std::string> closedPaths;
+    };
+
+    std::string BucketPath(const BucketKey& key, const std::string& suffix) const;
+    Record MakeRecord(const Node& node) const;
+    Node MakeNode(const Record& record, const BucketKey& key) const;
+
+    void AddToOpen(const Node& node);
+    std::optional<BucketKey> NextBucket() const;
+    // Sorts the open file of a bucket into runs, deleting the open file, and returns the paths of the runs
+    std::vector<std::string> SortOpen(const BucketKey& key);
+    // Expands every board in the bucket's open file which wasn't seen before, returning how many there were
+    uint64_t ExpandBucket(const BucketKey& key, uint64_t& iterations, uint64_t maxIterations);
+    void Expand(const Node& node);
+
+    std::optional<Record> FindClosed(const BucketKey& key, const PackedBoard& board) const;
+    Solution<Width, Height> ReconstructSolution() const;
+
+    Board<Width, Height> mInitialBoard;
+    Targets<Width, Height> mTargets;
+    Symmetry<Width, Height> mSymmetry;
+    const BoardLayout<Width, Height>& mLayout;
+    std::string mDirectory;
+    size_t mSortRecords;
+    std::map<BucketKey, Bucket> mBuckets;
+    uint64_t mNextFileId = 0;
+    std::optional<Node> mBestSolution;
+    uint64_t mDuplicates = 0;
+};
+
+template <size_t W, size_t H>
+ExternalSolver<W, H>::ExternalSolver(const Puzzle<W, H>& puzzle, const SolverOptions& options)
+    : mInitialBoard(puzzle.initialState),
+      mTargets(puzzle.TargetMap(), mInitialBoard, options),
+      mSymmetry(mInitialBoard.GetLayout(), mTargets, options.useSymmetry),
+      mLayout(mInitialBoard.GetLayout()),
+      mDirectory(options.externalDir),
+      mSortRecords(std::max<size_t>(options.externalSortRecords, 1))
+{
+    std::filesystem::create_directories(mDirectory);
+    Solution<W, H> initialSoln(puzzle.initialState, mTargets);
+    AddToOpen(NodeStore<W, H>::MakeRoot(initialSoln, mSymmetry));
+}
+
+template <size_t W, size_t H>
+ExternalSolver<W, H>::~ExternalSolver()
+{
+    for (auto& [key, bucket] : mBuckets)
+    {
+        // Writers have to be closed before their files are removed
+        if (bucket.open)
+        {
+            bucket.open.reset();
+            std::filesystem::remove(bucket.openPath);
+        }
+        for (const auto& path : bucket.closedPaths)
+        {
+            std::filesystem::remove(path);
+        }
+    }
+}
+
+template <size_t W, size_t H>
+Solution<W, H> ExternalSolver<W, H>::GenerateSolution(uint64_t maxIterations)
+{
+    std::cout << "[Info] Attempting to solve with buckets stored in " << mDirectory << ":\n" << mInitialBoard << std::endl;
+
+    uint64_t iterations = 0;
+    while (true)
+    {
+        std::optional<BucketKey> key = NextBucket();
+        if (!key)
+        {
+            if (mBestSolution)
+                break;
+
+            std::cerr << "[Error] Out of nodes to expand (explored " << iterations << " states, filtered " << mDuplicates << "), problem has no solution" << std::endl;
+            exit(1);
+        }
+
+        uint32_t f = key->first + key->second;
+        if (mBestSolution && mBestSolution->NOfMoves() <= f)
+        {
+            std::cout << "[Info] Next bucket's f-cost (" << f << ") exceeds bound of current solution (" << mBestSolution->NOfMoves() << "), terminating @ iteration " << iterations << std::endl;
+            break;
+        }
+
+        uint64_t expanded = ExpandBucket(*key, iterations, maxIterations);
+        std::cout << "[Info] Iteration " << iterations << ": expanded " << expanded << " states in bucket (g = " << key->first << ", h = "
+                  << key->second << "), # of filtered nodes = " << mDuplicates << ", found solution = " << mBestSolution.has_value() << std::endl;
+    }
+    return ReconstructSolution();
+}
+
+template <size_t W, size_t H>
+std::string ExternalSolver<W, H>::BucketPath(const BucketKey& key, const std::string& suffix) const
+{
+    return mDirectory + "/bucket_" + std::to_string(key.first) + '_' + std::to_string(key.second) + '_' + suffix;
+}
+
+template <size_t W, size_t H>
+typename ExternalSolver<W, H>::Record ExternalSolver<W, H>::MakeRecord(const Node& node) const
+{
+    // Value-initialised so the padding written to disk is deterministic
+    Record record{};
+    record.board = node.board.GetPackedBoard();
+    record.lastMove = node.lastMove;
+    record.symmetry = node.symmetry;
+    return record;
+}
+
+template <size_t W, size_t H>
+SearchNode<W, H> ExternalSolver<W, H>::MakeNode(const Record& record, const BucketKey& key) const
+{
+    return {Board<W, H>(mLayout, record.board), Node::kNoParent, record.lastMove, static_cast<uint16_t>(key.first), static_cast<uint16_t>(key.second), record.symmetry};
+}
+
+template <size_t W, size_t H>
+void ExternalSolver<W, H>::AddToOpen(const Node& node)
+{
+    BucketKey key{node.NOfMoves(), node.heuristicCost};
+    Bucket& bucket = mBuckets[key];
+    if (!bucket.open)
+    {
+        bucket.openPath = BucketPath(key, "open");
+        bucket.open = std::make_unique<RecordWriter>(bucket.openPath, sizeof(Record));
+    }
+    Record record = MakeRecord(node);
+    bucket.open->Write(&record);
+}
+
+template <size_t W, size_t H>
+std::optional<typename ExternalSolver<W, H>::BucketKey> ExternalSolver<W, H>::NextBucket() const
+{
+    // Successors of (g, h) with the same f-cost land in (g + 1, h - 1), so ties are broken by lowest g
+    std::optional<BucketKey> next;
+    for (const auto& [key, bucket] : mBuckets)
+    {
+        if (!bucket.open)
+            continue;
+        if (!next || key.first + key.second < next->first + next->second
+            || (key.first + key.second == next->first + next->second && key.first < next->first))
+            next = key;
+    }
+    return next;
+}
+
+template <size_t W, size_t H>
+std::vector<std::string> ExternalSolver<W, H>::SortOpen(const BucketKey& key)
+{
+    Bucket& bucket = mBuckets[key];
+    bucket.open->Close();
+    bucket.open.reset();
+
+    std::vector<std::string> runs;
+    std::vector<Record> chunk;
+    chunk.reserve(mSortRecords);
+    RecordReader reader(bucket.openPath, sizeof(Record));
+    for (uint64_t remaining = reader.size(); remaining > 0;)
+    {
+        chunk.clear();
+        for (; remaining > 0 && chunk.size() < mSortRecords; remaining--)
+        {
+            chunk.push_back(*static_cast<const Record*>(reader.Next()));
+        }
+        std::sort(chunk.begin(), chunk.end());
+        auto last = std::unique(chunk.begin(), chunk.end(), [](const Record& a, const Record& b) { return a.board == b.board; });
+        mDuplicates += static_cast<uint64_t>(chunk.end() - last);
+
+        runs.push_back(BucketPath(key, "run" + std::to_string(mNextFileId++)));
+        RecordWriter run(runs.back(), sizeof(Record));
+        for (auto it = chunk.begin(); it != last; it++)
+        {
+            run.Write(&*it);
+        }
+    }
+    std::filesystem::remove(bucket.openPath);
+    return runs;
+}
+
+template <size_t W, size_t H>
+uint64_t ExternalSolver<W, H>::ExpandBucket(const BucketKey& key, uint64_t& iterations, uint64_t maxIterations)
+{
+    std::vector<std::string> runPaths = SortOpen(key);
+
+    // k-way merge of the sorted runs
+    std::vector<std::unique_ptr<RecordReader>> runs;
+    using HeapEntry = std::pair<const Record*, size_t>;
+    auto isAfter = [](const HeapEntry& a, const HeapEntry& b) { return *b.first < *a.first; };
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, decltype(isAfter)> heap(isAfter);
+    for (const auto& path : runPaths)
+    {
+        runs.push_back(std::make_unique<RecordReader>(path, sizeof(Record)));
+        if (const void* record = runs.back()->Next())
+            heap.emplace(static_cast<const Record*>(record), runs.size() - 1);
+    }
+
+    // Cursors into every closed file the boards of this bucket could already be in
+    std::vector<std::unique_ptr<RecordReader>> closed;
+    std::vector<const Record*> closedHeads;
+    for (uint32_t back = 0; back <= 2 && back <= key.first; back++)
+    {
+        auto it = mBuckets.find({key.first - back, key.second});
+        if (it == mBuckets.end())
+            continue;
+        for (const auto& path : it->second.closedPaths)
+        {
+            closed.push_back(std::make_unique<RecordReader>(path, sizeof(Record)));
+            closedHeads.push_back(static_cast<const Record*>(closed.back()->Next()));
+        }
+    }
+
+    std::string closedPath = BucketPath(key, "closed" + std::to_string(mNextFileId++));
+    RecordWriter closedWriter(closedPath, sizeof(Record));
+    std::optional<Record> previous;
+    uint64_t expanded = 0;
+    while (!heap.empty())
+    {
+        auto [top, run] = heap.top();
+        heap.pop();
+        Record record = *top;
+        if (const void* next = runs[run]->Next())
+            heap.emplace(static_cast<const Record*>(next), run);
+
+        bool isDuplicate = previous && previous->board == record.board;
+        for (size_t i = 0; i < closed.size() && !isDuplicate; i++)
+        {
+            while (closedHeads[i] && *closedHeads[i] < record)
+                closedHeads[i] = static_cast<const Record*>(closed[i]->Next());
+            isDuplicate = closedHeads[i] && closedHeads[i]->board == record.board;
+        }
+        if (isDuplicate)
+        {
+            mDuplicates++;
+            continue;
+        }
+
+        previous = record;
+        closedWriter.Write(&record);
+        if (++iterations > maxIterations)
+        {
+            std::cerr << "[Error] Unable to find solution in " << maxIterations << " iterations, giving up." << std::endl;
+            exit(1);
+        }
+        Expand(MakeNode(record, key));
+        expanded++;
+    }
+
+    closedWriter.Close();
+    mBuckets[key].closedPaths.push_back(closedPath);
+    for (const auto& path : runPaths)
+    {
+        std::filesystem::remove(path);
+    }
+    return expanded;
+}
+
+template <size_t W, size_t H>
+void ExternalSolver<W, H>::Expand(const Node& node)
+{
+    for (const Move& move : node.board.GetPossibleMoves())
+    {
+        Node child = NodeStore<W, H>::MakeChild(node, move, mTargets, mSymmetry);
+        if (mBestSolution && mBestSolution->NOfMoves() <= child.GetTotalCost())
+            continue;
+
+        if (child.board.IsSolved(mTargets))
+        {
+            mBestSolution = child;
+            continue;
+        }
+        AddToOpen(child);
+    }
+}
+
+template <size_t W, size_t H>
+std::optional<typename ExternalSolver<W, H>::Record> ExternalSolver<W, H>::FindClosed(const BucketKey& key, const PackedBoard& board) const
+{
+    auto it = mBuckets.find(key);
+    if (it == mBuckets.end())
+        return {};
+
+    Record record;
+    for (const auto& path : it->second.closedPaths)
+    {
+        RecordReader reader(path, sizeof(Record));
+        uint64_t low = 0;
+        uint64_t high = reader.size();
+        while (low < high)
+        {
+            uint64_t mid = low + (high - low) / 2;
+            reader.ReadAt(mid, &record);
+            if (record.board < board)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low < reader.size())
+        {
+            reader.ReadAt(low, &record);
+            if (record.board == board)
+                return record;
+        }
+    }
+    return {};
+}
+
+template <size_t W, size_t H>
+Solution<W, H> ExternalSolver<W, H>::ReconstructSolution() const
+{
+    // Walks back from the solution, undoing the last move of each board (in the frame of its parent's stored board)
+    // to find its parent, which is then looked up in the closed bucket for its g and h
+    std::vector<Node> path{*mBestSolution};
+    while (path.back().NOfMoves() > 0)
+    {
+        const Node& child = path.back();
+        Board<W, H> parent = mSymmetry.Apply(mSymmetry.Inverse(child.symmetry), child.board);
+        parent.ApplyMove({child.lastMove.end, child.lastMove.start});
+
+        BucketKey key{child.NOfMoves() - 1u, parent.GetHeuristicCost(mTargets)};
+        std::optional<Record> record = FindClosed(key, parent.GetPackedBoard());
+        if (!record)
+        {
+            std::cerr << "[Error] Parent of a board on the solution path is missing from the closed buckets (should be impossible)" << std::endl;
+            exit(1);
+        }
+        path.push_back(MakeNode(*record, key));
+    }
+    std::reverse(path.begin(), path.end());
+
+    std::vector<const Node*> nodes;
+    for (const Node& node : path)
+    {
+        nodes.push_back(&node);
+    }
+    return NodeStore<W, H>::ReconstructSolution(nodes, mSymmetry);
+}
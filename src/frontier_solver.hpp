@@ -0,0 +1,329 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "solution.hpp"
+#include "symmetry.hpp"
+#include "node_table.hpp"
+#include "puzzles.hpp"
+#include "solver_options.hpp"
+
+// Breadth-first iterative-deepening A* (BFIDA*). Each iteration is a breadth-first search pruning nodes whose f-cost
+// exceeds a bound, which is raised to the smallest f-cost pruned until a solution is found. Every move can be undone,
+// so the neighbours of a board at depth d are at depth d - 1, d or d + 1, and only those three layers are kept for
+// duplicate detection: memory is O(frontier width) rather than O(states seen). No parent pointers are kept either.
+// Nodes past the middle of the bound only remember their ancestor in that (relay) layer, and the solution is rebuilt
+// by divide and conquer, searching again from the start to the relay and from the relay to the goal.
+template <size_t Width, size_t Height>
+class FrontierSolver
+{
+public:
+    FrontierSolver(const Puzzle<Width, Height>& puzzle, const SolverOptions& options = {})
+        : mInitialBoard(puzzle.initialState),
+          mTargets(puzzle.TargetMap(), mInitialBoard, options),
+          mSymmetry(mInitialBoard.GetLayout(), mTargets, options.useSymmetry)
+    {}
+
+    Solution<Width, Height> GenerateSolution(uint32_t maxIterations = 1000);
+
+private:
+    using PackedBoard = typename Board<Width, Height>::PackedBoard;
+    static constexpr uint32_t kNoRelay = UINT32_MAX;
+    static constexpr uint32_t kUnbounded = std::numeric_limits<uint32_t>::max();
+
+    struct LayerNode {
+        PackedBoard board;      // Canonicalised
+        uint32_t relay;         // Index of the node's ancestor in the relay layer, kNoRelay above that layer
+        uint16_t heuristicCost; // Towards the goal of the search the node belongs to
+    };
+
+    // Nodes at the same depth, with a table to look them up by board
+    struct Layer {
+        std::vector<LayerNode> nodes;
+        NodeTable table;
+
+        bool Contains(const Board<Width, Height>& board);
+        size_t BytesUsed() const { return nodes.capacity() * sizeof(LayerNode) + table.BytesUsed(); }
+    };
+
+    // A search looks either for a solved board, or for any image of a relay board found by an earlier search
+    struct Goal {
+        std::optional<PackedBoard> relay;
+        // The knights of each image of relay as targets, a board's heuristic cost is its lowest cost over them
+        std::vector<Targets<Width, Height>> relayTargets;
+    };
+
+    struct SearchResult {
+        bool isFound = false;
+        uint32_t depth = 0;              // Number of moves to the goal
+        uint32_t relayDepth = 0;
+        PackedBoard relay{};             // Canonical board at relayDepth on the path to the goal
+        uint32_t nextBound = kUnbounded; // Smallest f-cost exceeding the bound, when the goal wasn't found
+    };
+
+    Goal MakeRelayGoal(const PackedBoard& relay) const;
+    uint32_t GetHeuristicCost(const Board<Width, Height>& board, const Goal& goal) const;
+    bool IsGoal(const Board<Width, Height>& board, const Goal& goal) const;
+
+    // Breadth-first search from `from` towards goal, pruning nodes whose f-cost exceeds bound. The relay layer is at
+    // half the bound, so that a search bounded by the length of a shortest path splits it in two halves
+    SearchResult Search(const Board<Width, Height>& from, const Goal& goal, uint32_t bound);
+    // Returns the moves (in the orientation of `from`, which needn't be canonical) of the path found by result
+    std::vector<Move> Reconstruct(const Board<Width, Height>& from, const Goal& goal, const SearchResult& result);
+
+    Board<Width, Height> mInitialBoard;
+    Targets<Width, Height> mTargets;
+    Symmetry<Width, Height> mSymmetry;
+    Goal mSolvedGoal;
+    size_t mExpandedNodes = 0;
+    size_t mNOfSearches = 0;
+    size_t mPeakBytesUsed = 0;
+};
+
+template <size_t W, size_t H>
+Solution<W, H> FrontierSolver<W, H>::GenerateSolution(uint32_t maxIterations)
+{
+    std::cout << "[Info] Attempting to solve:\n" << mInitialBoard << std::endl;
+    uint32_t bound = mInitialBoard.GetHeuristicCost(mTargets);
+    for (uint32_t i = 0; i < maxIterations; i++)
+    {
+        std::cout << "[Info] Iteration " << i << ": searching with bound = " << bound << ", # of expanded nodes = " << mExpandedNodes << ", peak memory = " << mPeakBytesUsed / (1024 * 1024) << "MB" << std::endl;
+        SearchResult result = Search(mInitialBoard, mSolvedGoal, bound);
+        if (result.isFound)
+        {
+            std::cout << "[Info] Found optimal solution with bound = " << bound << ", terminating @ iteration " << i << " (expanded " << mExpandedNodes << " nodes), reconstructing it" << std::endl;
+            size_t nOfSearches = mNOfSearches;
+            std::vector<Move> moves = Reconstruct(mInitialBoard, mSolvedGoal, result);
+
+            Board<W, H> initialBoard = mInitialBoard;
+            Solution<W, H> solution(std::move(initialBoard), mTargets);
+            for (Move& move : moves)
+            {
+                solution.ApplyMove(std::move(move), mTargets);
+            }
+            std::cout << "[Info] Reconstructed the solution with " << mNOfSearches - nOfSearches << " segment searches (expanded " << mExpandedNodes << " nodes in total), peak of "
+                      << mPeakBytesUsed / (1024 * 1024) << "MB used by the layers" << std::endl;
+            return solution;
+        }
+        if (result.nextBound == kUnbounded)
+        {
+            std::cerr << "[Error] Out of nodes to expand (expanded " << mExpandedNodes << " nodes), problem has no solution" << std::endl;
+            exit(1);
+        }
+        bound = result.nextBound;
+    }
+    std::cerr << "[Error] Unable to find solution in " << maxIterations << " iterations, giving up." << std::endl;
+    exit(1);
+}
+
+template <size_t W, size_t H>
+bool FrontierSolver<W, H>::Layer::Contains(const Board<W, H>& board)
+{
+    auto isMatch = [this, &board](uint32_t index) { return nodes[index].board == board.GetPackedBoard(); };
+    return table.Find(board.Hash(), isMatch) != nullptr;
+}
+
+template <size_t W, size_t H>
+typename FrontierSolver<W, H>::Goal FrontierSolver<W, H>::MakeRelayGoal(const PackedBoard& relay) const
+{
+    // Every knight of a colour has to end up on a distinct tile holding that colour in the relay, which is what the
+    // matching heuristic charges for
+    SolverOptions options;
+    options.heuristic = HeuristicMode::MATCHING;
+    Goal goal{relay, {}};
+    Board<W, H> relayBoard(mInitialBoard.GetLayout(), relay);
+    for (uint8_t transform = 0; transform < mSymmetry.size(); transform++)
+    {
+        Board<W, H> image = mSymmetry.Apply(transform, relayBoard);
+        typename Targets<W, H>::TargetMap positions;
+        for (int8_t y = 0; y < image.height(); y++)
+        {
+            for (int8_t x = 0; x < image.width(); x++)
+            {
+                BoardState state = image.at({x, y});
+                if (state == BoardState::BLUE)
+                    positions[Target::BLUE].push_back({x, y});
+                else if (state == BoardState::RED)
+                    positions[Target::RED].push_back({x, y});
+            }
+        }
+        goal.relayTargets.emplace_back(std::move(positions), image, options);
+    }
+    return goal;
+}
+
+template <size_t W, size_t H>
+uint32_t FrontierSolver<W, H>::GetHeuristicCost(const Board<W, H>& board, const Goal& goal) const
+{
+    if (!goal.relay)
+        return board.GetHeuristicCost(mTargets);
+
+    uint32_t minCost = kUnbounded;
+    for (const Targets<W, H>& targets : goal.relayTargets)
+    {
+        minCost = std::min(minCost, board.GetHeuristicCost(targets));
+    }
+    return minCost;
+}
+
+template <size_t W, size_t H>
+bool FrontierSolver<W, H>::IsGoal(const Board<W, H>& board, const Goal& goal) const
+{
+    return goal.relay ? board.GetPackedBoard() == *goal.relay : board.IsSolved(mTargets);
+}
+
+template <size_t W, size_t H>
+typename FrontierSolver<W, H>::SearchResult FrontierSolver<W, H>::Search(const Board<W, H>& from, const Goal& goal, uint32_t bound)
+{
+    mNOfSearches++;
+    SearchResult result;
+    result.relayDepth = bound / 2;
+    std::vector<PackedBoard> relays;
+
+    Board<W, H> start = from;
+    mSymmetry.Canonicalise(start);
+    uint32_t startCost = GetHeuristicCost(start, goal);
+    if (IsGoal(start, goal))
+    {
+        result.isFound = true;
+        return result;
+    }
+    if (startCost > bound)
+    {
+        result.nextBound = startCost;
+        return result;
+    }
+
+    Layer previous;
+    Layer current;
+    Layer next;
+    uint32_t startRelay = kNoRelay;
+    if (result.relayDepth == 0)
+    {
+        startRelay = 0;
+        relays.push_back(start.GetPackedBoard());
+    }
+    current.table.FindOrInsert(start.Hash(), [](uint32_t) { return false; }).first->SetOpen(0);
+    current.nodes.push_back({start.GetPackedBoard(), startRelay, static_cast<uint16_t>(startCost)});
+
+    const BoardLayout<W, H>& layout = mInitialBoard.GetLayout();
+    for (uint32_t depth = 0; !current.nodes.empty(); depth++)
+    {
+        uint32_t childDepth = depth + 1;
+        for (const LayerNode& node : current.nodes)
+        {
+            mExpandedNodes++;
+            Board<W, H> board(layout, node.board);
+            for (const Move& move : board.GetPossibleMoves())
+            {
+                // The heuristic towards a solved board is invariant under the puzzle's symmetries and can be updated
+                // incrementally, the one towards a relay is the lowest over its images so it's recomputed
+                Board<W, H> child = board;
+                uint32_t heuristicCost = node.heuristicCost;
+                if (goal.relay)
+                {
+                    child.ApplyMove(move);
+                    heuristicCost = GetHeuristicCost(child, goal);
+                }
+                else
+                {
+                    ApplyMoveWithHeuristic(child, heuristicCost, move, mTargets);
+                }
+                if (childDepth + heuristicCost > bound)
+                {
+                    result.nextBound = std::min(result.nextBound, childDepth + heuristicCost);
+                    continue;
+                }
+
+                mSymmetry.Canonicalise(child);
+                if (previous.Contains(child) || current.Contains(child))
+                    continue;
+                auto isMatch = [&next, &child](uint32_t index) { return next.nodes[index].board == child.GetPackedBoard(); };
+                auto [entry, inserted] = next.table.FindOrInsert(child.Hash(), isMatch);
+                if (!inserted)
+                    continue;
+
+                uint32_t relay = node.relay;
+                if (childDepth == result.relayDepth)
+                {
+                    relay = static_cast<uint32_t>(relays.size());
+                    relays.push_back(child.GetPackedBoard());
+                }
+                if (IsGoal(child, goal))
+                {
+                    result.isFound = true;
+                    result.depth = childDepth;
+                    // Only happens if the bound exceeds the length of the path found, the goal is then its own relay
+                    // and Reconstruct searches again with a tighter bound
+                    if (relay == kNoRelay)
+                        result.relayDepth = childDepth;
+                    result.relay = relay == kNoRelay ? child.GetPackedBoard() : relays[relay];
+                    return result;
+                }
+                entry->SetOpen(static_cast<uint32_t>(next.nodes.size()));
+                next.nodes.push_back({child.GetPackedBoard(), relay, static_cast<uint16_t>(heuristicCost)});
+            }
+        }
+
+        mPeakBytesUsed = std::max(mPeakBytesUsed, previous.BytesUsed() + current.BytesUsed() + next.BytesUsed() + relays.capacity() * sizeof(PackedBoard));
+        previous = std::move(current);
+        current = std::move(next);
+        next = Layer();
+    }
+    return result;
+}
+
+template <size_t W, size_t H>
+std::vector<Move> FrontierSolver<W, H>::Reconstruct(const Board<W, H>& from, const Goal& goal, const SearchResult& result)
+{
+    if (result.depth == 0)
+        return {};
+    if (result.depth == 1)
+    {
+        for (const Move& move : from.GetPossibleMoves())
+        {
+            Board<W, H> child = from;
+            child.ApplyMove(move);
+            mSymmetry.Canonicalise(child);
+            if (IsGoal(child, goal))
+                return {move};
+        }
+    }
+    else if (result.relayDepth == result.depth)
+    {
+        return Reconstruct(from, goal, Search(from, goal, result.depth));
+    }
+    else
+    {
+        // Both halves of a shortest path are shortest paths themselves, so a search bounded by the length of each
+        // half finds it (again splitting it at its middle)
+        Goal relayGoal = MakeRelayGoal(result.relay);
+        SearchResult first = Search(from, relayGoal, result.relayDepth);
+        if (first.isFound)
+        {
+            std::vector<Move> moves = Reconstruct(from, relayGoal, first);
+            Board<W, H> relay = from;
+            for (const Move& move : moves)
+            {
+                relay.ApplyMove(move);
+            }
+
+            SearchResult second = Search(relay, goal, result.depth - result.relayDepth);
+            if (second.isFound)
+            {
+                std::vector<Move> secondMoves = Reconstruct(relay, goal, second);
+                moves.insert(moves.end(), secondMoves.begin(), secondMoves.end());
+                return moves;
+            }
+        }
+    }
+
+    std::cerr << "[Error] Unable to rebuild a segment of " << result.depth << " moves of the solution (should be impossible)" << std::endl;
+    exit(1);
+}
@@ -2,12 +2,19 @@
 
 #include <cstdint>
 
-#include "common.hpp"
 
 namespace Helpers {
-// Returns fewest moves for a knight to reach a destination assuming an infinitely large, empty chessboard.
-// See https://stackoverflow.com/a/41704071 for more details
-uint32_t MinimumMovesToDestination(const BoardPos& curr, const BoardPos& dest);
+// Spreads the bits of a hash (e.g. Board::Hash, which can be the raw packed board) so its low bits can be used
+// as an index into a power-of-two sized table
+constexpr uint64_t MixHash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
 
 constexpr unsigned floorlog2(unsigned x)
 {
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "solution.hpp"
+#include "symmetry.hpp"
+#include "helper.hpp"
+#include "puzzles.hpp"
+#include "solver_options.hpp"
+
+// Iterative-deepening A* solver. Rather than keeping every generated state alive like Solver, it repeatedly runs a
+// depth-first search bounded by f-cost, raising the bound to the smallest f-cost which exceeded it after each failed
+// iteration. The search path is a single Solution which moves are applied to and undone from in-place, so memory
+// usage is O(depth) plus an optional fixed-size transposition table used to cut re-expansions of states reached
+// through different move orders.
+template <size_t Width, size_t Height>
+class IdaSolver
+{
+public:
+    IdaSolver(const Puzzle<Width, Height>& puzzle, const SolverOptions& options = {})
+        : mTargets(puzzle.TargetMap(), Board<Width, Height>(puzzle.initialState), options),
+          mSymmetry(Board<Width, Height>(puzzle.initialState).GetLayout(), mTargets, options.useSymmetry),
+          mPath(puzzle.initialState, mTargets),
+          mTranspositionTable(options.transpositionTableEntries ? std::bit_floor(options.transpositionTableEntries) : 0)
+    {}
+
+    Solution<Width, Height> GenerateSolution(uint32_t maxIterations = 1000);
+
+private:
+    static constexpr uint32_t kFound = 0;
+    static constexpr uint32_t kUnbounded = std::numeric_limits<uint32_t>::max();
+
+    struct TranspositionEntry {
+        typename Board<Width, Height>::PackedBoard board;
+        uint16_t iteration = 0; // 0 marks an unused entry, iterations are numbered from 1
+        uint16_t nOfMoves = 0;
+    };
+
+    // Returns kFound if a solution was found (mPath then holds it), otherwise the smallest f-cost exceeding bound
+    uint32_t Search(uint32_t bound);
+    // Returns true if the current board was already reached in this iteration with no more moves than now
+    bool IsTransposition();
+
+    Targets<Width, Height> mTargets;
+    Symmetry<Width, Height> mSymmetry;
+    Solution<Width, Height> mPath;
+    std::vector<TranspositionEntry> mTranspositionTable;
+    uint16_t mIteration = 0;
+    size_t mExpandedNodes = 0;
+    size_t mTranspositions = 0;
+};
+
+template <size_t W, size_t H>
+Solution<W, H> IdaSolver<W, H>::GenerateSolution(uint32_t maxIterations)
+{
+    std::cout << "[Info] Attempting to solve:\n" << mPath.board << std::endl;
+    uint32_t bound = mPath.GetTotalCost();
+    for (uint32_t i = 0; i < maxIterations; i++)
+    {
+        mIteration++;
+        std::cout << "[Info] Iteration " << i << ": searching with bound = " << bound << ", # of expanded nodes = " << mExpandedNodes << ", # of transpositions = " << mTranspositions << std::endl;
+        uint32_t nextBound = Search(bound);
+        if (nextBound == kFound)
+        {
+            std::cout << "[Info] Found optimal solution with bound = " << bound << ", terminating @ iteration " << i << " (expanded " << mExpandedNodes << " nodes)" << std::endl;
+            return mPath;
+        }
+        if (nextBound == kUnbounded)
+        {
+            std::cerr << "[Error] Out of nodes to expand (expanded " << mExpandedNodes << " nodes), problem has no solution" << std::endl;
+            exit(1);
+        }
+        bound = nextBound;
+    }
+    std::cerr << "[Error] Unable to find solution in " << maxIterations << " iterations, giving up." << std::endl;
+    exit(1);
+}
+
+template <size_t W, size_t H>
+uint32_t IdaSolver<W, H>::Search(uint32_t bound)
+{
+    uint32_t totalCost = mPath.GetTotalCost();
+    if (totalCost > bound)
+        return totalCost;
+    if (mPath.IsComplete(mTargets))
+        return kFound;
+    if (IsTransposition())
+        return kUnbounded;
+
+    mExpandedNodes++;
+    uint32_t minExceedingCost = kUnbounded;
+    for (Move& move : mPath.board.GetPossibleMoves())
+    {
+        // Undoing the previous move can never be part of an optimal solution
+        if (!mPath.moves.empty() && move.start == mPath.moves.back().end && move.end == mPath.moves.back().start)
+            continue;
+
+        mPath.ApplyMove(std::move(move), mTargets);
+        uint32_t cost = Search(bound);
+        if (cost == kFound)
+            return kFound;
+        mPath.UndoMove(mTargets);
+        minExceedingCost = std::min(minExceedingCost, cost);
+    }
+    return minExceedingCost;
+}
+
+template <size_t W, size_t H>
+bool IdaSolver<W, H>::IsTransposition()
+{
+    if (mTranspositionTable.empty())
+        return false;
+
+    // Mirror images of a board have the same subtree up to symmetry, so they share an entry
+    Board<W, H> canonical = mPath.board;
+    mSymmetry.Canonicalise(canonical);
+    size_t index = Helpers::MixHash(canonical.Hash()) & (mTranspositionTable.size() - 1);
+    TranspositionEntry& entry = mTranspositionTable[index];
+    const auto& board = canonical.GetPackedBoard();
+    uint16_t nOfMoves = static_cast<uint16_t>(mPath.NOfMoves());
+    if (entry.iteration == mIteration && entry.board == board && entry.nOfMoves <= nOfMoves)
+    {
+        // Everything reachable from here was already searched with at least as much of the bound remaining
+        mTranspositions++;
+        return true;
+    }
+
+    // Always replace, recently visited states are the most likely to be reached again
+    entry = {board, mIteration, nOfMoves};
+    return false;
+}
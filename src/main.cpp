@@ -1,13 +1,185 @@
 #include <iostream>
+#include <string_view>
+#include <string>
+#include <thread>
 
 #include "board.hpp"
 #include "solver.hpp"
+#include "ida_solver.hpp"
+#include "parallel_solver.hpp"
+#include "external_solver.hpp"
+#include "frontier_solver.hpp"
+#include "batch_solver.hpp"
+#include "solver_options.hpp"
 #include "puzzles.hpp"
 
-int main()
+namespace {
+void PrintUsage(const char* program)
 {
-    Solver solver(std::move(Puzzles::King_E1));
+    std::cerr << "Usage: " << program << " [--ida | --frontier | --threads <n> | --external <dir>] [--heuristic nearest|matching|pdb] [--no-symmetry] [--max-memory <MB> | --partial-expansion] [--stats <file>] [--stats-interval <ms>]\n"
+              << "       [--checkpoint <file> [--checkpoint-interval <s>] [--resume]] [--batch <file> [--output <file>]]\n"
+              << "  --ida                 Use iterative-deepening A* (bounded memory)\n"
+              << "  --frontier            Use breadth-first iterative-deepening A*, keeping only the frontier layers\n"
+              << "  --threads <n>         Use hash-distributed A* over n threads (0 = all cores)\n"
+              << "  --external <dir>      Use external-memory A*, keeping the open and closed lists in files under dir\n"
+              << "  --heuristic <mode>    nearest: charge each knight its nearest target (default)\n"
+              << "                        matching: charge the cheapest assignment of knights to targets\n"
+              << "                        pdb: look up exact per-colour costs in pattern databases (built in pdb/)\n"
+              << "  --no-symmetry         Don't merge mirror images of boards on symmetric puzzles\n"
+              << "  --max-memory <MB>     Bound the memory of the default A* solver, forgetting and later regenerating the worst nodes\n"
+              << "  --partial-expansion   Only generate the children of the default A* solver's nodes with the f-cost being expanded\n"
+              << "  --stats <file>        Append the default A* solver's search counters to file as JSON lines while it runs\n"
+              << "  --stats-interval <ms> Interval between lines of --stats (default 1000)\n"
+              << "  --checkpoint <file>   Periodically save the default A* solver's state to file, and when interrupted\n"
+              << "  --checkpoint-interval <s>  Interval between checkpoints (default 600)\n"
+              << "  --resume              Carry on from the state saved in the --checkpoint file\n"
+              << "  --batch <file>        Solve every puzzle of a puzzle file, --threads at a time (default all cores)\n"
+              << "  --output <file>       Write the results of --batch to file as JSON lines (default results.jsonl)" << std::endl;
+}
+}
 
-    auto solution = solver.GenerateSolution(10000000);
+int main(int argc, char* argv[])
+{
+    SolverOptions options;
+    bool useIda = false;
+    bool useFrontier = false;
+    bool useThreads = false;
+    bool useExternal = false;
+    std::string batchPath;
+    std::string outputPath = "results.jsonl";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg == "--ida")
+        {
+            useIda = true;
+        }
+        else if (arg == "--frontier")
+        {
+            useFrontier = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            useThreads = true;
+            options.nOfThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+            if (options.nOfThreads == 0)
+                options.nOfThreads = std::thread::hardware_concurrency();
+        }
+        else if (arg == "--external" && i + 1 < argc)
+        {
+            useExternal = true;
+            options.externalDir = argv[++i];
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "nearest")
+        {
+            options.heuristic = HeuristicMode::NEAREST_TARGET;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "matching")
+        {
+            options.heuristic = HeuristicMode::MATCHING;
+            i++;
+        }
+        else if (arg == "--heuristic" && i + 1 < argc && std::string_view(argv[i + 1]) == "pdb")
+        {
+            options.heuristic = HeuristicMode::PATTERN_DATABASE;
+            i++;
+        }
+        else if (arg == "--no-symmetry")
+        {
+            options.useSymmetry = false;
+        }
+        else if (arg == "--max-memory" && i + 1 < argc)
+        {
+            options.maxMemory = std::stoull(argv[++i]) * 1024 * 1024;
+        }
+        else if (arg == "--partial-expansion")
+        {
+            options.usePartialExpansion = true;
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            options.statsPath = argv[++i];
+        }
+        else if (arg == "--stats-interval" && i + 1 < argc)
+        {
+            options.statsIntervalMs = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--checkpoint" && i + 1 < argc)
+        {
+            options.checkpointPath = argv[++i];
+        }
+        else if (arg == "--checkpoint-interval" && i + 1 < argc)
+        {
+            options.checkpointIntervalSeconds = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--resume")
+        {
+            options.resume = true;
+        }
+        else if (arg == "--batch" && i + 1 < argc)
+        {
+            batchPath = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.resume && options.checkpointPath.empty())
+    {
+        std::cerr << "[Error] --resume needs the --checkpoint file to resume from" << std::endl;
+        return 1;
+    }
+
+    if (!batchPath.empty())
+    {
+        BatchSolver batch(options, outputPath);
+        return batch.Run(batchPath) ? 1 : 0;
+    }
+
+    if (useIda)
+    {
+        IdaSolver solver(Puzzles::King_E1, options);
+        auto solution = solver.GenerateSolution();
+        std::cout << solution << std::endl;
+        return 0;
+    }
+
+    if (useFrontier)
+    {
+        FrontierSolver solver(Puzzles::King_E1, options);
+        auto solution = solver.GenerateSolution();
+        std::cout << solution << std::endl;
+        return 0;
+    }
+
+    if (useThreads)
+    {
+        ParallelSolver solver(Puzzles::King_E1, options);
+        auto solution = solver.GenerateSolution();
+        std::cout << solution << std::endl;
+        return 0;
+    }
+
+    if (useExternal)
+    {
+        ExternalSolver solver(Puzzles::King_E1, options);
+        auto solution = solver.GenerateSolution();
+        std::cout << solution << std::endl;
+        return 0;
+    }
+
+    // The built-in puzzle's BLOCKED tiles are known at compile time, so the solver is specialised for them
+    Solver<5, 5, Puzzles::StaticLayoutOf<Puzzles::King_E1>> solver(Puzzles::King_E1, options);
+
+    // Memory-bounded and partial expansion searches trade memory for re-expansions, so don't cap their iterations
+    auto solution = solver.GenerateSolution(options.maxMemory || options.usePartialExpansion ? UINT32_MAX : 10000000);
     std::cout << solution << std::endl;
-}
\ No newline at end of file
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <array>
+
+#include "common.hpp"
+
+// Fixed-capacity list of moves, so generating successors doesn't need a heap allocation per expanded node
+template <size_t Capacity>
+class MoveList {
+public:
+    void push_back(const Move& move) { mMoves[mSize++] = move; }
+    // Branch-free push_back: move is always written, but only kept if isKept is true
+    void PushBackIf(const Move& move, bool isKept)
+    {
+        mMoves[mSize] = move;
+        mSize += isKept;
+    }
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    const Move& operator[](size_t index) const { return mMoves[index]; }
+
+    Move* begin() { return mMoves.data(); }
+    Move* end() { return mMoves.data() + mSize; }
+    const Move* begin() const { return mMoves.data(); }
+    const Move* end() const { return mMoves.data() + mSize; }
+
+private:
+    // One spare entry, which PushBackIf may write to on a full list
+    std::array<Move, Capacity + 1> mMoves;
+    size_t mSize = 0;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "solution.hpp"
+#include "symmetry.hpp"
+#include "checkpoint.hpp"
+#include "slab_array.hpp"
+
+// Compact search node, the move history is not stored but can be rebuilt by following the parent indices. Boards are
+// stored canonicalised, symmetry is the transform mapping the board reached by lastMove (in the frame of the parent's
+// board) to the stored one
+template <size_t Width, size_t Height, typename LayoutPolicy = RuntimeLayout<Width, Height>>
+struct SearchNode {
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    Board<Width, Height, LayoutPolicy> board;
+    uint32_t parent;
+    Move lastMove;
+    uint16_t nOfMoves;
+    uint16_t heuristicCost;
+    uint8_t symmetry;
+
+    uint32_t GetTotalCost() const { return NOfMoves() + heuristicCost; }
+    uint32_t NOfMoves() const { return nOfMoves; }
+};
+
+// Owns every node generated during a search, nodes are referenced by their 32-bit index. Slots of nodes which were
+// freed are reused by later nodes, so indices are only stable while a node is live. Nodes are kept in slabs, which
+// are all freed together with the store
+template <size_t Width, size_t Height, typename LayoutPolicy = RuntimeLayout<Width, Height>>
+class NodeStore {
+public:
+    using Node = SearchNode<Width, Height, LayoutPolicy>;
+
+    static Node MakeRoot(const Solution<Width, Height, LayoutPolicy>& root, const Symmetry<Width, Height>& symmetry);
+    static Node MakeChild(const Node& parent, const Move& move, const Targets<Width, Height>& targets, const Symmetry<Width, Height>& symmetry);
+    Node MakeChild(uint32_t parent, const Move& move, const Targets<Width, Height>& targets, const Symmetry<Width, Height>& symmetry) const;
+
+    uint32_t Add(const Node& node);
+    // Releases the slot of a node nothing refers to anymore, for reuse by a later Add
+    void Free(uint32_t index) { mFreeSlots.push_back(index); }
+    const Node& operator[](uint32_t index) const { return mNodes[index]; }
+    void reserve(size_t nOfNodes) { mNodes.reserve(nOfNodes); }
+    size_t size() const { return mNodes.size(); }
+    size_t NOfLiveNodes() const { return mNodes.size() - mFreeSlots.size(); }
+    size_t NOfSlabs() const { return mNodes.NOfSlabs(); }
+    size_t BytesUsed() const { return mNodes.BytesUsed() + mFreeSlots.capacity() * sizeof(uint32_t); }
+
+    Solution<Width, Height, LayoutPolicy> ReconstructSolution(uint32_t index, const Symmetry<Width, Height>& symmetry) const;
+    // Rebuilds the solution ending at the last node of path (ordered from the root), mapping the moves of each node
+    // back to the orientation of the initial board
+    static Solution<Width, Height, LayoutPolicy> ReconstructSolution(const std::vector<const Node*>& path, const Symmetry<Width, Height>& symmetry);
+
+    // Nodes are saved without their layout (every board of a search shares it), which Load takes instead
+    void Save(CheckpointWriter& writer) const;
+    void Load(CheckpointReader& reader, const BoardLayout<Width, Height>& layout);
+
+private:
+    struct StoredNode {
+        typename Board<Width, Height, LayoutPolicy>::PackedBoard board;
+        uint32_t parent;
+        Move lastMove;
+        uint16_t nOfMoves;
+        uint16_t heuristicCost;
+        uint8_t symmetry;
+    };
+
+    SlabArray<Node> mNodes;
+    std::vector<uint32_t> mFreeSlots;
+};
+
+template <size_t W, size_t H, typename L>
+SearchNode<W, H, L> NodeStore<W, H, L>::MakeRoot(const Solution<W, H, L>& root, const Symmetry<W, H>& symmetry)
+{
+    Node node{root.board, Node::kNoParent, {}, static_cast<uint16_t>(root.NOfMoves()), static_cast<uint16_t>(root.heuristicCost), Symmetry<W, H>::kIdentity};
+    node.symmetry = symmetry.Canonicalise(node.board);
+    return node;
+}
+
+template <size_t W, size_t H, typename L>
+SearchNode<W, H, L> NodeStore<W, H, L>::MakeChild(const Node& parent, const Move& move, const Targets<W, H>& targets, const Symmetry<W, H>& symmetry)
+{
+    Node child = parent;
+    uint32_t heuristicCost = child.heuristicCost;
+    ApplyMoveWithHeuristic(child.board, heuristicCost, move, targets);
+
+    // The heuristic is invariant under the puzzle's symmetries, so it carries over to the canonical board
+    child.lastMove = move;
+    child.nOfMoves++;
+    child.heuristicCost = static_cast<uint16_t>(heuristicCost);
+    child.symmetry = symmetry.Canonicalise(child.board);
+    return child;
+}
+
+template <size_t W, size_t H, typename L>
+SearchNode<W, H, L> NodeStore<W, H, L>::MakeChild(uint32_t parent, const Move& move, const Targets<W, H>& targets, const Symmetry<W, H>& symmetry) const
+{
+    Node child = MakeChild(mNodes[parent], move, targets, symmetry);
+    child.parent = parent;
+    return child;
+}
+
+template <size_t W, size_t H, typename L>
+uint32_t NodeStore<W, H, L>::Add(const Node& node)
+{
+    if (!mFreeSlots.empty())
+    {
+        uint32_t index = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        mNodes[index] = node;
+        return index;
+    }
+    mNodes.push_back(node);
+    return static_cast<uint32_t>(mNodes.size() - 1);
+}
+
+template <size_t W, size_t H, typename L>
+Solution<W, H, L> NodeStore<W, H, L>::ReconstructSolution(uint32_t index, const Symmetry<W, H>& symmetry) const
+{
+    std::vector<const Node*> path;
+    path.reserve(mNodes[index].NOfMoves() + 1);
+    for (uint32_t curr = index; curr != Node::kNoParent; curr = mNodes[curr].parent)
+    {
+        path.push_back(&mNodes[curr]);
+    }
+    std::reverse(path.begin(), path.end());
+    return ReconstructSolution(path, symmetry);
+}
+
+template <size_t W, size_t H, typename L>
+Solution<W, H, L> NodeStore<W, H, L>::ReconstructSolution(const std::vector<const Node*>& path, const Symmetry<W, H>& symmetry)
+{
+    // frame maps the stored board of the current node back to the board actually reached from the initial board
+    uint8_t frame = symmetry.Inverse(path.front()->symmetry);
+    std::vector<Move> moves;
+    moves.reserve(path.size() - 1);
+    for (size_t i = 1; i < path.size(); i++)
+    {
+        moves.push_back(symmetry.Apply(frame, path[i]->lastMove));
+        frame = symmetry.Compose(frame, symmetry.Inverse(path[i]->symmetry));
+    }
+    const Node& last = *path.back();
+    return Solution<W, H, L>(symmetry.Apply(frame, last.board), std::move(moves), last.heuristicCost);
+}
+
+template <size_t W, size_t H, typename L>
+void NodeStore<W, H, L>::Save(CheckpointWriter& writer) const
+{
+    writer.WriteValue<uint64_t>(mNodes.size());
+    for (size_t i = 0; i < mNodes.size(); i++)
+    {
+        const Node& node = mNodes[i];
+        // Value-initialised so the padding written to disk is deterministic
+        StoredNode stored{};
+        stored.board = node.board.GetPackedBoard();
+        stored.parent = node.parent;
+        stored.lastMove = node.lastMove;
+        stored.nOfMoves = node.nOfMoves;
+        stored.heuristicCost = node.heuristicCost;
+        stored.symmetry = node.symmetry;
+        writer.WriteValue(stored);
+    }
+    writer.WriteVector(mFreeSlots);
+}
+
+template <size_t W, size_t H, typename L>
+void NodeStore<W, H, L>::Load(CheckpointReader& reader, const BoardLayout<W, H>& layout)
+{
+    // Cleared rather than reassigned, so memory reserved up front for a bounded search is kept
+    mNodes.clear();
+    uint64_t nOfNodes = reader.ReadValue<uint64_t>();
+    mNodes.reserve(nOfNodes);
+    for (uint64_t i = 0; i < nOfNodes; i++)
+    {
+        StoredNode stored = reader.ReadValue<StoredNode>();
+        mNodes.push_back({Board<W, H, L>(layout, stored.board), stored.parent, stored.lastMove, stored.nOfMoves, stored.heuristicCost, stored.symmetry});
+    }
+    reader.ReadVector(mFreeSlots);
+}
@@ -0,0 +1,72 @@
+#include "node_table.hpp"
+
+#include <bit>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+void NodeTable::Grow()
+{
+    std::vector<Entry> oldEntries(mEntries.size() * 2);
+    std::swap(oldEntries, mEntries);
+
+    size_t mask = mEntries.size() - 1;
+    for (const Entry& entry : oldEntries)
+    {
+        if (entry.IsEmpty())
+            continue;
+
+        size_t i = entry.mHash & mask;
+        while (!mEntries[i].IsEmpty())
+            i = (i + 1) & mask;
+        mEntries[i] = entry;
+    }
+}
+
+void NodeTable::Erase(Entry* entry)
+{
+    // Backward-shift deletion: later entries of the probe sequence are moved into the hole whenever it lies between
+    // their home slot and themselves, so lookups never stop early at the gap and no tombstones are needed
+    size_t mask = mEntries.size() - 1;
+    size_t hole = static_cast<size_t>(entry - mEntries.data());
+    for (size_t i = (hole + 1) & mask; !mEntries[i].IsEmpty(); i = (i + 1) & mask)
+    {
+        size_t home = mEntries[i].mHash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            mEntries[hole] = mEntries[i];
+            hole = i;
+        }
+    }
+    mEntries[hole] = Entry();
+    mSize--;
+}
+
+void NodeTable::Reserve(size_t nOfEntries)
+{
+    while (mEntries.size() < CapacityFor(nOfEntries))
+        Grow();
+}
+
+size_t NodeTable::CapacityFor(size_t nOfEntries)
+{
+    size_t minCapacity = (nOfEntries * kMaxLoadDenominator + kMaxLoadNumerator - 1) / kMaxLoadNumerator;
+    return std::max(kInitialCapacity, std::bit_ceil(minCapacity));
+}
+
+void NodeTable::Save(CheckpointWriter& writer) const
+{
+    writer.WriteVector(mEntries);
+    writer.WriteValue<uint64_t>(mSize);
+}
+
+void NodeTable::Load(CheckpointReader& reader)
+{
+    reader.ReadVector(mEntries);
+    mSize = reader.ReadValue<uint64_t>();
+    if (!std::has_single_bit(mEntries.size()) || mSize > mEntries.size())
+    {
+        std::cerr << "[Error] Checkpoint " << reader.path() << " holds a corrupt node table" << std::endl;
+        exit(1);
+    }
+}
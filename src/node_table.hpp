@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+#include "helper.hpp"
+#include "checkpoint.hpp"
+
+// Open-addressing (linear probing) hash table mapping boards to the node storing them. Keys aren't stored in the
+// table itself, entries only hold a 32-bit hash and the index of the node, so key comparisons are delegated to a
+// predicate provided by the caller which checks whether a node index refers to the board being looked up.
+// Each entry also tracks whether its node has been expanded (closed) or is still in the open list.
+class NodeTable {
+public:
+    class Entry {
+    public:
+        bool IsEmpty() const { return mNode == kEmpty; }
+        bool IsClosed() const { return mNode & kClosedBit; }
+        uint32_t Node() const { return mNode & ~kClosedBit; }
+
+        void SetOpen(uint32_t node) { mNode = node; }
+        void SetClosed() { mNode |= kClosedBit; }
+
+    private:
+        friend class NodeTable;
+        static constexpr uint32_t kClosedBit = 1u << 31;
+        static constexpr uint32_t kEmpty = UINT32_MAX;
+
+        uint32_t mHash = 0;
+        uint32_t mNode = kEmpty;
+    };
+
+    NodeTable() : mEntries(kInitialCapacity) {}
+
+    // Returns the entry for the board matched by isMatch, or nullptr if there is none
+    template <typename Pred>
+    Entry* Find(size_t hash, Pred&& isMatch);
+
+    // Returns the entry for the board matched by isMatch, and whether it was inserted by this call. Inserted entries
+    // are empty, and must be assigned a node by the caller before the table is used again
+    template <typename Pred>
+    std::pair<Entry*, bool> FindOrInsert(size_t hash, Pred&& isMatch);
+    // Starts loading the first entry probed for hash into the cache, so a lookup of it issued a little later (after
+    // other work, or lookups of other hashes) doesn't stall on a cache miss
+    void Prefetch(size_t hash) const { __builtin_prefetch(&mEntries[MixHash(hash) & (mEntries.size() - 1)]); }
+    // Removes entry (which must have been returned by Find or FindOrInsert), invalidating pointers to other entries
+    void Erase(Entry* entry);
+
+    // Grows the table up front so nOfEntries entries can be inserted without rehashing
+    void Reserve(size_t nOfEntries);
+    // Capacity the table needs to hold nOfEntries entries
+    static size_t CapacityFor(size_t nOfEntries);
+
+    void Save(CheckpointWriter& writer) const;
+    void Load(CheckpointReader& reader);
+
+    size_t size() const { return mSize; }
+    size_t capacity() const { return mEntries.size(); }
+    size_t BytesUsed() const { return mEntries.capacity() * sizeof(Entry); }
+    double MeanProbeLength() const { return mLookups ? static_cast<double>(mProbes) / static_cast<double>(mLookups) : 0.0; }
+
+private:
+    static constexpr size_t kInitialCapacity = 1024;
+    // Grow once the table is 70% full, past that linear probing sequences get long quickly
+    static constexpr size_t kMaxLoadNumerator = 7;
+    static constexpr size_t kMaxLoadDenominator = 10;
+
+    static uint32_t MixHash(size_t hash);
+    void Grow();
+
+    std::vector<Entry> mEntries;
+    size_t mSize = 0;
+    size_t mLookups = 0;
+    size_t mProbes = 0;
+};
+
+inline uint32_t NodeTable::MixHash(size_t hash)
+{
+    return static_cast<uint32_t>(Helpers::MixHash(hash));
+}
+
+template <typename Pred>
+NodeTable::Entry* NodeTable::Find(size_t hash, Pred&& isMatch)
+{
+    uint32_t mixed = MixHash(hash);
+    size_t mask = mEntries.size() - 1;
+    mLookups++;
+    for (size_t i = mixed & mask;; i = (i + 1) & mask)
+    {
+        mProbes++;
+        Entry& entry = mEntries[i];
+        if (entry.IsEmpty())
+            return nullptr;
+        if (entry.mHash == mixed && isMatch(entry.Node()))
+            return &entry;
+    }
+}
+
+template <typename Pred>
+std::pair<NodeTable::Entry*, bool> NodeTable::FindOrInsert(size_t hash, Pred&& isMatch)
+{
+    if ((mSize + 1) * kMaxLoadDenominator > mEntries.size() * kMaxLoadNumerator)
+        Grow();
+
+    uint32_t mixed = MixHash(hash);
+    size_t mask = mEntries.size() - 1;
+    mLookups++;
+    for (size_t i = mixed & mask;; i = (i + 1) & mask)
+    {
+        mProbes++;
+        Entry& entry = mEntries[i];
+        if (entry.IsEmpty())
+        {
+            entry.mHash = mixed;
+            mSize++;
+            return {&entry, true};
+        }
+        if (entry.mHash == mixed && isMatch(entry.Node()))
+            return {&entry, false};
+    }
+}
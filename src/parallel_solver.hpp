@@ -0,0 +1,393 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+#include <bit>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "solution.hpp"
+#include "node_store.hpp"
+#include "symmetry.hpp"
+#include "bucket_queue.hpp"
+#include "node_table.hpp"
+#include "helper.hpp"
+#include "puzzles.hpp"
+#include "solver_options.hpp"
+
+// Hash-distributed A* (HDA*). Every board is owned by a single worker thread, picked from its hash, which keeps its
+// own open list and node table for the boards it owns. Children generated by a worker are sent to their owner in
+// batches through lock-free inboxes, so no locks are taken on the hot path.
+//
+// A worker runs out of work once it has no open node cheaper than the best solution found so far (by any worker).
+// The search terminates once every worker is out of work and no batches are in flight, at which point no open node
+// anywhere can lead to a cheaper solution, so the best solution is optimal.
+template <size_t Width, size_t Height>
+class ParallelSolver
+{
+public:
+    ParallelSolver(const Puzzle<Width, Height>& puzzle, const SolverOptions& options = {});
+
+    Solution<Width, Height> GenerateSolution(uint64_t maxIterations = 100000000);
+
+private:
+    using Node = SearchNode<Width, Height>;
+
+    static constexpr size_t kBatchSize = 256;
+    static constexpr uint64_t kReportInterval = 100000;
+    static constexpr uint64_t kFlushInterval = 16;
+
+    struct Batch {
+        Batch() { nodes.reserve(kBatchSize); }
+
+        Batch* next = nullptr;
+        std::vector<Node> nodes;
+    };
+
+    struct Worker {
+        NodeStore<Width, Height> nodes;
+        BucketQueue availableNodes;
+        NodeTable nodeTable;
+        size_t openNodes = 0;
+        size_t filteredSolutions = 0;
+        std::atomic<Batch*> inbox = nullptr;
+        // One partially filled batch per destination worker
+        std::vector<std::unique_ptr<Batch>> outgoing;
+
+        ~Worker()
+        {
+            // Batches can be left unprocessed if the search gave up
+            for (Batch* batch = inbox.load(); batch;)
+            {
+                std::unique_ptr<Batch> unprocessed(batch);
+                batch = batch->next;
+            }
+        }
+    };
+
+    // Node references are global: the owning worker is stored in the low bits of a node's parent index
+    uint32_t EncodeRef(uint32_t worker, uint32_t index) const;
+    uint32_t WorkerMask() const { return (1u << mWorkerBits) - 1; }
+    uint32_t OwnerOf(const Board<Width, Height>& board) const;
+
+    void RunWorker(uint32_t self, uint64_t maxIterations);
+    void Expand(uint32_t self, uint32_t index);
+    void Send(uint32_t self, uint32_t owner, const Node& node);
+    void Flush(uint32_t self, uint32_t owner);
+    // Returns the number of batches received
+    size_t ReceiveBatches(uint32_t self);
+    void InsertNode(uint32_t self, const Node& node);
+    std::optional<uint32_t> GetNextNode(uint32_t self);
+    void UpdateBestSolution(uint32_t self, const Node& candidate);
+    Solution<Width, Height> ReconstructSolution(uint32_t ref) const;
+
+    Targets<Width, Height> mTargets;
+    Symmetry<Width, Height> mSymmetry;
+    uint32_t mWorkerBits;
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    uint32_t mRootRef;
+
+    // Number of workers with work left plus the number of batches in flight, the search is over once it hits 0
+    std::atomic<int64_t> mActive = 0;
+    std::atomic<bool> mDone = false;
+    std::atomic<bool> mGaveUp = false;
+    std::atomic<uint64_t> mIterations = 0;
+    std::atomic<uint32_t> mBestCost = UINT32_MAX;
+    std::mutex mBestSolutionMutex;
+    std::optional<uint32_t> mBestSolution;
+};
+
+template <size_t W, size_t H>
+ParallelSolver<W, H>::ParallelSolver(const Puzzle<W, H>& puzzle, const SolverOptions& options)
+    : mTargets(puzzle.TargetMap(), Board<W, H>(puzzle.initialState), options),
+      mSymmetry(Board<W, H>(puzzle.initialState).GetLayout(), mTargets, options.useSymmetry),
+      mWorkerBits(static_cast<uint32_t>(std::bit_width(std::max(options.nOfThreads, 1u) - 1)))
+{
+    uint32_t nOfThreads = std::max(options.nOfThreads, 1u);
+    for (uint32_t i = 0; i < nOfThreads; i++)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+        mWorkers.back()->outgoing.resize(nOfThreads);
+    }
+
+    Solution<W, H> initialSoln(puzzle.initialState, mTargets);
+    Node root = NodeStore<W, H>::MakeRoot(initialSoln, mSymmetry);
+    uint32_t owner = OwnerOf(root.board);
+    InsertNode(owner, root);
+    mRootRef = EncodeRef(owner, 0);
+}
+
+template <size_t W, size_t H>
+uint32_t ParallelSolver<W, H>::EncodeRef(uint32_t worker, uint32_t index) const
+{
+    if (index >= (Node::kNoParent >> mWorkerBits))
+    {
+        std::cerr << "[Error] Worker " << worker << " ran out of node indices (" << index << " nodes stored)" << std::endl;
+        exit(1);
+    }
+    return (index << mWorkerBits) | worker;
+}
+
+template <size_t W, size_t H>
+uint32_t ParallelSolver<W, H>::OwnerOf(const Board<W, H>& board) const
+{
+    // NodeTable indexes with the low bits of the mixed hash, so use the high ones to pick the owner
+    return static_cast<uint32_t>((Helpers::MixHash(board.Hash()) >> 32) % mWorkers.size());
+}
+
+template <size_t W, size_t H>
+Solution<W, H> ParallelSolver<W, H>::GenerateSolution(uint64_t maxIterations)
+{
+    const Node& root = mWorkers[mRootRef & WorkerMask()]->nodes[mRootRef >> mWorkerBits];
+    std::cout << "[Info] Attempting to solve with " << mWorkers.size() << " threads:\n" << mSymmetry.Apply(mSymmetry.Inverse(root.symmetry), root.board) << std::endl;
+
+    mActive = static_cast<int64_t>(mWorkers.size());
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < mWorkers.size(); i++)
+    {
+        threads.emplace_back(&ParallelSolver::RunWorker, this, i, maxIterations);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    size_t filteredSolutions = 0;
+    for (const auto& worker : mWorkers)
+    {
+        filteredSolutions += worker->filteredSolutions;
+    }
+
+    if (mGaveUp)
+    {
+        std::cerr << "[Error] Unable to find solution in " << maxIterations << " iterations, giving up." << std::endl;
+        exit(1);
+    }
+    if (!mBestSolution)
+    {
+        std::cerr << "[Error] Out of nodes to expand (explored " << mIterations << " states, filtered " << filteredSolutions << "), problem has no solution" << std::endl;
+        exit(1);
+    }
+
+    std::cout << "[Info] All workers exhausted nodes cheaper than the best solution, found optimal solution, terminating @ iteration " << mIterations << std::endl;
+    return ReconstructSolution(*mBestSolution);
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::RunWorker(uint32_t self, uint64_t maxIterations)
+{
+    Worker& worker = *mWorkers[self];
+    bool isActive = true;
+    uint64_t expansions = 0;
+    while (!mDone.load(std::memory_order_relaxed))
+    {
+        if (!isActive)
+        {
+            if (worker.inbox.load(std::memory_order_acquire) == nullptr)
+            {
+                if (mActive.load(std::memory_order_acquire) == 0)
+                    mDone = true;
+                std::this_thread::yield();
+                continue;
+            }
+            // Become active before receiving, so mActive can't drop to 0 while the batches are being processed
+            mActive.fetch_add(1, std::memory_order_acq_rel);
+            isActive = true;
+        }
+
+        size_t nOfBatches = ReceiveBatches(self);
+        if (nOfBatches)
+            mActive.fetch_sub(static_cast<int64_t>(nOfBatches), std::memory_order_acq_rel);
+
+        std::optional<uint32_t> next = GetNextNode(self);
+        if (!next)
+        {
+            for (uint32_t owner = 0; owner < mWorkers.size(); owner++)
+            {
+                Flush(self, owner);
+            }
+            mActive.fetch_sub(1, std::memory_order_acq_rel);
+            isActive = false;
+            continue;
+        }
+
+        uint64_t iteration = mIterations.fetch_add(1, std::memory_order_relaxed);
+        if (iteration >= maxIterations)
+        {
+            mGaveUp = true;
+            mDone = true;
+            break;
+        }
+        if (iteration % kReportInterval == 0)
+            std::cout << "[Info] Iteration " << iteration << ": # of pending nodes on worker " << self << " = " << worker.openNodes << ", found solution = " << (mBestCost.load(std::memory_order_relaxed) != UINT32_MAX) << '\n';
+
+        Expand(self, *next);
+        // Partially filled batches are sent periodically so other workers aren't starved while this one is busy
+        if (++expansions % kFlushInterval == 0)
+        {
+            for (uint32_t owner = 0; owner < mWorkers.size(); owner++)
+            {
+                Flush(self, owner);
+            }
+        }
+    }
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::Expand(uint32_t self, uint32_t index)
+{
+    Worker& worker = *mWorkers[self];
+    for (const Move& move : worker.nodes[index].board.GetPossibleMoves())
+    {
+        Node candidate = worker.nodes.MakeChild(index, move, mTargets, mSymmetry);
+        candidate.parent = EncodeRef(self, index);
+        if (candidate.GetTotalCost() >= mBestCost.load(std::memory_order_relaxed))
+            continue;
+
+        if (candidate.board.IsSolved(mTargets))
+        {
+            UpdateBestSolution(self, candidate);
+            continue;
+        }
+
+        uint32_t owner = OwnerOf(candidate.board);
+        if (owner == self)
+            InsertNode(self, candidate);
+        else
+            Send(self, owner, candidate);
+    }
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::Send(uint32_t self, uint32_t owner, const Node& node)
+{
+    auto& batch = mWorkers[self]->outgoing[owner];
+    if (!batch)
+        batch = std::make_unique<Batch>();
+
+    batch->nodes.push_back(node);
+    if (batch->nodes.size() == kBatchSize)
+        Flush(self, owner);
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::Flush(uint32_t self, uint32_t owner)
+{
+    auto& batch = mWorkers[self]->outgoing[owner];
+    if (!batch || batch->nodes.empty())
+        return;
+
+    // The batch counts as active work until its receiver has processed it
+    mActive.fetch_add(1, std::memory_order_acq_rel);
+    Batch* sent = batch.release();
+    std::atomic<Batch*>& inbox = mWorkers[owner]->inbox;
+    sent->next = inbox.load(std::memory_order_relaxed);
+    while (!inbox.compare_exchange_weak(sent->next, sent, std::memory_order_release, std::memory_order_relaxed))
+    {}
+}
+
+template <size_t W, size_t H>
+size_t ParallelSolver<W, H>::ReceiveBatches(uint32_t self)
+{
+    // Taking the whole inbox at once means there is a single consumer, so the stack doesn't suffer from ABA
+    Batch* batch = mWorkers[self]->inbox.exchange(nullptr, std::memory_order_acquire);
+    size_t nOfBatches = 0;
+    while (batch)
+    {
+        std::unique_ptr<Batch> received(batch);
+        batch = batch->next;
+        for (const Node& node : received->nodes)
+        {
+            InsertNode(self, node);
+        }
+        nOfBatches++;
+    }
+    return nOfBatches;
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::InsertNode(uint32_t self, const Node& node)
+{
+    Worker& worker = *mWorkers[self];
+    if (node.GetTotalCost() >= mBestCost.load(std::memory_order_relaxed))
+    {
+        worker.filteredSolutions++;
+        return;
+    }
+
+    const Board<W, H>& nodeBoard = node.board;
+    auto isMatch = [&worker, &nodeBoard](uint32_t index) { return worker.nodes[index].board == nodeBoard; };
+    auto [entry, inserted] = worker.nodeTable.FindOrInsert(nodeBoard.Hash(), isMatch);
+    if (!inserted)
+    {
+        if (node.NOfMoves() >= worker.nodes[entry->Node()].NOfMoves())
+        {
+            worker.filteredSolutions++;
+            return;
+        }
+        // Workers only expand nodes in order of their own queue, so unlike Solver a closed node can still be reached
+        // through a shorter path later on, in which case it's reopened. Otherwise the existing node's queue entry
+        // becomes stale once its handle is replaced below
+        if (!entry->IsClosed())
+            worker.openNodes--;
+    }
+
+    uint32_t index = worker.nodes.Add(node);
+    entry->SetOpen(index);
+    worker.availableNodes.Push(index, node.GetTotalCost(), node.NOfMoves());
+    worker.openNodes++;
+}
+
+template <size_t W, size_t H>
+std::optional<uint32_t> ParallelSolver<W, H>::GetNextNode(uint32_t self)
+{
+    Worker& worker = *mWorkers[self];
+    // Nodes are popped in order of cost, so once the cheapest can't beat the best solution none of the others can
+    while (!worker.availableNodes.empty() && worker.availableNodes.MinCost() < mBestCost.load(std::memory_order_relaxed))
+    {
+        uint32_t top = worker.availableNodes.Pop();
+        const Board<W, H>& topBoard = worker.nodes[top].board;
+        auto isMatch = [&worker, &topBoard](uint32_t index) { return worker.nodes[index].board == topBoard; };
+        NodeTable::Entry* entry = worker.nodeTable.Find(topBoard.Hash(), isMatch);
+        if (entry->IsClosed() || entry->Node() != top)
+            continue;
+
+        entry->SetClosed();
+        worker.openNodes--;
+        return top;
+    }
+    return {};
+}
+
+template <size_t W, size_t H>
+void ParallelSolver<W, H>::UpdateBestSolution(uint32_t self, const Node& candidate)
+{
+    std::lock_guard<std::mutex> lock(mBestSolutionMutex);
+    if (candidate.NOfMoves() >= mBestCost.load(std::memory_order_relaxed))
+        return;
+
+    mBestSolution = EncodeRef(self, mWorkers[self]->nodes.Add(candidate));
+    mBestCost.store(candidate.NOfMoves(), std::memory_order_relaxed);
+}
+
+template <size_t W, size_t H>
+Solution<W, H> ParallelSolver<W, H>::ReconstructSolution(uint32_t ref) const
+{
+    std::vector<const Node*> path;
+    for (const Node* curr = &mWorkers[ref & WorkerMask()]->nodes[ref >> mWorkerBits];;)
+    {
+        path.push_back(curr);
+        if (curr->parent == Node::kNoParent)
+            break;
+        curr = &mWorkers[curr->parent & WorkerMask()]->nodes[curr->parent >> mWorkerBits];
+    }
+    std::reverse(path.begin(), path.end());
+    return NodeStore<W, H>::ReconstructSolution(path, mSymmetry);
+}
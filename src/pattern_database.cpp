@@ -0,0 +1,262 @@
+#include "pattern_database.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "helper.hpp"
+
+struct PatternDatabase::Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t nOfEntries;
+};
+
+namespace {
+constexpr char kMagic[4] = {'K', 'P', 'D', 'B'};
+constexpr uint32_t kVersion = 2;
+
+// Contents of a slot while building a database
+constexpr uint8_t kFree = 0;
+constexpr uint8_t kPatternKnight = 1;
+constexpr uint8_t kOtherKnight = 2;
+
+uint64_t ComputeKey(const PatternDatabase::Abstraction& abstraction)
+{
+    uint64_t key = Helpers::MixHash(abstraction.nOfKnights);
+    auto combine = [&key](uint64_t value) { key = Helpers::MixHash(key ^ (value + 0x9e3779b97f4a7c15ULL)); };
+    combine(abstraction.nOfOthers);
+    for (const auto& neighbours : abstraction.slotNeighbours)
+    {
+        combine(neighbours.size());
+        for (uint8_t neighbour : neighbours)
+            combine(neighbour);
+    }
+    for (uint8_t target : abstraction.targetSlots)
+        combine(target);
+    return key;
+}
+}
+
+PatternDatabase::PatternDatabase(const Abstraction& abstraction)
+    : mBinomialStride(std::max(abstraction.nOfKnights, abstraction.nOfOthers) + 1)
+{
+    size_t nOfSlots = abstraction.slotNeighbours.size();
+    mBinomials.assign((nOfSlots + 1) * mBinomialStride, 0);
+    for (size_t n = 0; n <= nOfSlots; n++)
+    {
+        mBinomials[n * mBinomialStride] = 1;
+        for (size_t k = 1; k < mBinomialStride && k <= n; k++)
+        {
+            mBinomials[n * mBinomialStride + k] = Binomial(n - 1, k - 1) + Binomial(n - 1, k);
+        }
+    }
+    mNOfOtherPlacements = Binomial(nOfSlots - abstraction.nOfKnights, abstraction.nOfOthers);
+    mNOfEntries = Binomial(nOfSlots, abstraction.nOfKnights) * mNOfOtherPlacements;
+}
+
+PatternDatabase::~PatternDatabase()
+{
+    if (mMapping)
+        munmap(mMapping, mMappingSize);
+}
+
+std::unique_ptr<PatternDatabase> PatternDatabase::LoadOrBuild(const std::string& directory, const std::string& name, const Abstraction& abstraction)
+{
+    // Solvers running concurrently (see BatchSolver) would otherwise build the same database at once
+    static std::mutex buildMutex;
+    std::lock_guard<std::mutex> lock(buildMutex);
+    std::unique_ptr<PatternDatabase> database(new PatternDatabase(abstraction));
+    if (database->mNOfEntries > kMaxEntries)
+    {
+        std::cerr << "[Warning] Pattern database " << name << " would need " << database->mNOfEntries << " entries (limit is " << kMaxEntries << "), not using it" << std::endl;
+        return nullptr;
+    }
+
+    uint64_t key = ComputeKey(abstraction);
+    std::ostringstream path;
+    path << directory << '/' << name << '_' << std::hex << std::setw(16) << std::setfill('0') << key << ".pdb";
+    if (database->Map(path.str(), key))
+        return database;
+
+    std::cout << "[Info] Building pattern database " << path.str() << " (" << database->mNOfEntries << " entries)" << std::endl;
+    database->Build(path.str(), key, abstraction);
+    if (!database->Map(path.str(), key))
+    {
+        std::cerr << "[Error] Unable to map pattern database " << path.str() << " after building it" << std::endl;
+        exit(1);
+    }
+    return database;
+}
+
+bool PatternDatabase::Map(const std::string& path, uint64_t key)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    size_t expectedSize = sizeof(Header) + mNOfEntries;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expectedSize)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, expectedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const Header* header = static_cast<const Header*>(mapping);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion || header->key != key || header->nOfEntries != mNOfEntries)
+    {
+        munmap(mapping, expectedSize);
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingSize = expectedSize;
+    mData = static_cast<const uint8_t*>(mapping) + sizeof(Header);
+    return true;
+}
+
+void PatternDatabase::Build(const std::string& path, uint64_t key, const Abstraction& abstraction) const
+{
+    size_t nOfSlots = abstraction.slotNeighbours.size();
+    uint32_t nOfKnights = abstraction.nOfKnights;
+    uint32_t nOfOthers = abstraction.nOfOthers;
+
+    // Placements are handled as the contents of every slot, which makes both ranking and generating moves simple
+    auto rank = [&](const std::vector<uint8_t>& slots) {
+        uint64_t patternRank = 0;
+        uint64_t otherRank = 0;
+        uint32_t i = 0;
+        uint32_t j = 0;
+        for (size_t slot = 0; slot < nOfSlots; slot++)
+        {
+            if (slots[slot] == kPatternKnight)
+                patternRank += RankTerm(slot, i++);
+            else if (slots[slot] == kOtherKnight)
+                otherRank += RankTerm(slot - i, j++);
+        }
+        return patternRank * mNOfOtherPlacements + otherRank;
+    };
+    std::vector<uint8_t> freeSlots;
+    auto unrank = [&](uint64_t entry, std::vector<uint8_t>& slots) {
+        std::fill(slots.begin(), slots.end(), kFree);
+        uint64_t r = entry / mNOfOtherPlacements;
+        size_t n = nOfSlots;
+        for (uint32_t i = nOfKnights; i-- > 0;)
+        {
+            // Largest slot s such that C(s, i + 1) <= r
+            do { n--; } while (Binomial(n, i + 1) > r);
+            slots[n] = kPatternKnight;
+            r -= Binomial(n, i + 1);
+        }
+
+        freeSlots.clear();
+        for (size_t slot = 0; slot < nOfSlots; slot++)
+        {
+            if (slots[slot] == kFree)
+                freeSlots.push_back(static_cast<uint8_t>(slot));
+        }
+        r = entry % mNOfOtherPlacements;
+        n = freeSlots.size();
+        for (uint32_t j = nOfOthers; j-- > 0;)
+        {
+            do { n--; } while (Binomial(n, j + 1) > r);
+            slots[freeSlots[n]] = kOtherKnight;
+            r -= Binomial(n, j + 1);
+        }
+    };
+
+    // Retrograde BFS from every goal placement. Knight moves are reversible, so the predecessors of a placement are
+    // the same as its successors. Moves of other knights are free, so states reached through them are searched at
+    // the current depth (a 0-1 BFS)
+    std::vector<uint8_t> distances(mNOfEntries, kUnreachable);
+    std::vector<uint64_t> frontier;
+    std::vector<uint8_t> slots(nOfSlots);
+    for (uint64_t entry = 0; entry < mNOfEntries; entry += mNOfOtherPlacements)
+    {
+        unrank(entry, slots);
+        bool coversTargets = std::all_of(abstraction.targetSlots.begin(), abstraction.targetSlots.end(),
+            [&slots](uint8_t target) { return slots[target] == kPatternKnight; });
+        if (!coversTargets)
+            continue;
+
+        for (uint64_t goal = entry; goal < entry + mNOfOtherPlacements; goal++)
+        {
+            distances[goal] = 0;
+            frontier.push_back(goal);
+        }
+    }
+
+    std::vector<uint64_t> nextFrontier;
+    for (uint32_t depth = 0; !frontier.empty() && depth + 1 < kUnreachable; depth++)
+    {
+        // The frontier grows while it's being searched, so it can't be iterated over directly
+        for (size_t i = 0; i < frontier.size(); i++)
+        {
+            uint64_t entry = frontier[i];
+            // Skips entries which were reached at a lower depth after being queued
+            if (distances[entry] != depth)
+                continue;
+
+            unrank(entry, slots);
+            for (size_t slot = 0; slot < nOfSlots; slot++)
+            {
+                if (slots[slot] == kFree)
+                    continue;
+
+                uint32_t cost = depth + (slots[slot] == kPatternKnight);
+                for (uint8_t neighbour : abstraction.slotNeighbours[slot])
+                {
+                    if (slots[neighbour] != kFree)
+                        continue;
+
+                    std::swap(slots[slot], slots[neighbour]);
+                    uint64_t next = rank(slots);
+                    std::swap(slots[slot], slots[neighbour]);
+                    if (distances[next] <= cost)
+                        continue;
+
+                    distances[next] = static_cast<uint8_t>(cost);
+                    (cost == depth ? frontier : nextFrontier).push_back(next);
+                }
+            }
+        }
+        std::swap(frontier, nextFrontier);
+        nextFrontier.clear();
+    }
+    // Written to a temporary file first so other processes never map a partially written database
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+    std::string tempPath = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.key = key;
+        header.nOfEntries = mNOfEntries;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(distances.data()), static_cast<std::streamsize>(distances.size()));
+        if (!out)
+        {
+            std::cerr << "[Error] Unable to write pattern database to " << tempPath << std::endl;
+            exit(1);
+        }
+    }
+    std::filesystem::rename(tempPath, path);
+}
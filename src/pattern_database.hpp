@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Pattern database for a single colour of knights: for every placement of the knights of that colour and of the
+// remaining knights (which are treated as indistinguishable), the fewest moves of knights of that colour needed to
+// fill every target of that colour. Moves of the other knights are free, so each database only counts moves of its
+// own colour and databases for different colours can be added together.
+//
+// Placements are ranked using the combinatorial number system over the (sorted) slots of the packed board, i.e.
+// rank = sum(C(slot_i, i + 1)), so the rank can be accumulated while walking over the knights of a board. The other
+// knights are ranked the same way over the slots not taken by the pattern knights, so an entry sits at
+// patternRank * C(nOfSlots - nOfKnights, nOfOthers) + otherRank.
+// Databases are stored on disk and memory-mapped, so they are only built once and shared between processes.
+class PatternDatabase {
+public:
+    static constexpr uint8_t kUnreachable = UINT8_MAX;
+
+    struct Abstraction {
+        // Knight-move neighbours of each slot of the packed board
+        std::vector<std::vector<uint8_t>> slotNeighbours;
+        std::vector<uint8_t> targetSlots;
+        uint32_t nOfKnights;
+        uint32_t nOfOthers;
+    };
+
+    ~PatternDatabase();
+    PatternDatabase(const PatternDatabase&) = delete;
+    PatternDatabase& operator=(const PatternDatabase&) = delete;
+
+    // Maps the database for abstraction stored under directory, building and saving it first if it doesn't exist.
+    // Returns nullptr if the database would be larger than kMaxEntries
+    static std::unique_ptr<PatternDatabase> LoadOrBuild(const std::string& directory, const std::string& name, const Abstraction& abstraction);
+
+    // Term of the rank contributed by the index-th knight (in slot order) sitting on slot. For other knights, slot
+    // only counts the slots not taken by pattern knights
+    uint64_t RankTerm(size_t slot, uint32_t index) const { return mBinomials[slot * mBinomialStride + index + 1]; }
+    uint8_t Lookup(uint64_t patternRank, uint64_t otherRank) const { return mData[patternRank * mNOfOtherPlacements + otherRank]; }
+
+private:
+    static constexpr uint64_t kMaxEntries = uint64_t{1} << 28;
+
+    struct Header;
+
+    explicit PatternDatabase(const Abstraction& abstraction);
+
+    uint64_t Binomial(size_t n, size_t k) const { return k > n ? 0 : mBinomials[n * mBinomialStride + k]; }
+    bool Map(const std::string& path, uint64_t key);
+    void Build(const std::string& path, uint64_t key, const Abstraction& abstraction) const;
+
+    // mBinomials[n * mBinomialStride + k] = C(n, k)
+    size_t mBinomialStride;
+    std::vector<uint64_t> mBinomials;
+    uint64_t mNOfOtherPlacements;
+    uint64_t mNOfEntries;
+    void* mMapping = nullptr;
+    size_t mMappingSize = 0;
+    const uint8_t* mData = nullptr;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "board_layout.hpp"
+#include "puzzle_file.hpp"
+#include "puzzles.hpp"
+
+namespace {
+template <size_t W, size_t H>
+Puzzle<W, H> MakePuzzle(const PuzzleDescription& description)
+{
+    Puzzle<W, H> puzzle;
+    for (size_t y = 0; y < H; y++)
+    {
+        for (size_t x = 0; x < W; x++)
+        {
+            puzzle.initialState[y][x] = description.rows[y][x];
+        }
+    }
+    for (const auto& [target, tiles] : description.targets)
+    {
+        typename Puzzle<W, H>::TargetTiles entry{target, {}};
+        for (const BoardPos& tile : tiles)
+        {
+            entry.tiles.push_back(tile);
+        }
+        puzzle.targets.push_back(entry);
+    }
+    return puzzle;
+}
+
+template <typename Func, size_t... Indices>
+decltype(auto) DispatchToSize(const PuzzleDescription& description, Func& func, std::index_sequence<Indices...>)
+{
+    using Result = decltype(func(MakePuzzle<1, 1>(description)));
+    using Entry = Result (*)(const PuzzleDescription&, Func&);
+    // Index = (W - 1) * MAX_BOARD_SIZE + (H - 1)
+    static constexpr Entry kTable[] = {
+        [](const PuzzleDescription& d, Func& f) -> Result {
+            return f(MakePuzzle<Indices / MAX_BOARD_SIZE + 1, Indices % MAX_BOARD_SIZE + 1>(d));
+        }...
+    };
+    return kTable[(description.width - 1) * MAX_BOARD_SIZE + description.height - 1](description, func);
+}
+}
+
+// Calls func with description turned into the Puzzle<W, H> of its size, through a table of func instantiated for
+// every size up to MAX_BOARD_SIZE x MAX_BOARD_SIZE. Every instantiation of func must return the same type.
+// PuzzleReader only produces descriptions within those sizes
+template <typename Func>
+decltype(auto) DispatchPuzzle(const PuzzleDescription& description, Func&& func)
+{
+    return DispatchToSize(description, func, std::make_index_sequence<MAX_BOARD_SIZE * MAX_BOARD_SIZE>());
+}
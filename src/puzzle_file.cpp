@@ -0,0 +1,119 @@
+#include "puzzle_file.hpp"
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+#include "board_layout.hpp"
+
+namespace {
+// Tiles a puzzle row may hold, as in boardStateMapping
+constexpr std::string_view kTileChars = " BRYX";
+}
+
+PuzzleReader::PuzzleReader(const std::string& path)
+    : mPath(path), mFile(path)
+{
+    if (!mFile)
+    {
+        std::cerr << "[Error] Unable to open " << mPath << " for reading" << std::endl;
+        exit(1);
+    }
+}
+
+bool PuzzleReader::ReadLine()
+{
+    while (std::getline(mFile, mLine))
+    {
+        mLineNumber++;
+        if (!mLine.empty() && mLine.back() == '\r')
+            mLine.pop_back();
+        size_t first = mLine.find_first_not_of(" \t");
+        if (first != std::string::npos && mLine[first] != '#')
+        {
+            // Rows keep their inner spaces, only the indentation of a line is dropped
+            mLine.erase(0, first);
+            return true;
+        }
+    }
+    return false;
+}
+
+void PuzzleReader::Fail(const std::string& message) const
+{
+    std::cerr << "[Error] " << mPath << ':' << mLineNumber << ": " << message << std::endl;
+    exit(1);
+}
+
+std::optional<PuzzleDescription> PuzzleReader::Next()
+{
+    if (!mHasLine && !ReadLine())
+        return std::nullopt;
+    mHasLine = false;
+
+    std::istringstream header(mLine);
+    std::string keyword;
+    PuzzleDescription puzzle;
+    if (!(header >> keyword >> puzzle.name) || keyword != "puzzle")
+        Fail("expected 'puzzle <name>'");
+
+    while (ReadLine())
+    {
+        if (mLine.front() == '|')
+        {
+            if (!puzzle.targets.empty())
+                Fail("rows of " + puzzle.name + " must come before its targets");
+            size_t end = mLine.find('|', 1);
+            if (end == std::string::npos)
+                Fail("row isn't closed by '|'");
+            std::string row = mLine.substr(1, end - 1);
+            if (row.find_first_not_of(kTileChars) != std::string::npos)
+                Fail("row holds a tile other than '" + std::string(kTileChars) + "'");
+            if (!puzzle.rows.empty() && row.size() != puzzle.rows.front().size())
+                Fail("rows of " + puzzle.name + " have different widths");
+            puzzle.rows.push_back(std::move(row));
+            continue;
+        }
+
+        std::istringstream line(mLine);
+        std::string colour;
+        line >> colour;
+        if (colour != "B" && colour != "R")
+        {
+            // Start of the next puzzle
+            mHasLine = true;
+            break;
+        }
+        auto& positions = puzzle.targets[colour == "B" ? Target::BLUE : Target::RED];
+        for (std::string tile; line >> tile;)
+        {
+            int column = tile[0] - 'a';
+            int row = tile.size() > 1 ? std::atoi(tile.c_str() + 1) - 1 : -1;
+            if (tile.size() < 2 || column < 0 || column >= static_cast<int>(MAX_BOARD_SIZE) || row < 0 || row >= static_cast<int>(MAX_BOARD_SIZE))
+                Fail("invalid target tile '" + tile + "'");
+            positions.push_back({static_cast<int8_t>(column), static_cast<int8_t>(row)});
+        }
+    }
+
+    puzzle.height = puzzle.rows.size();
+    puzzle.width = puzzle.height ? puzzle.rows.front().size() : 0;
+    if (puzzle.width == 0 || puzzle.height == 0 || puzzle.width > MAX_BOARD_SIZE || puzzle.height > MAX_BOARD_SIZE)
+        Fail(puzzle.name + " must be between 1x1 and " + std::to_string(MAX_BOARD_SIZE) + 'x' + std::to_string(MAX_BOARD_SIZE) + " tiles");
+    std::array<bool, MAX_BOARD_SIZE * MAX_BOARD_SIZE> isTarget{};
+    for (const auto& [target, positions] : puzzle.targets)
+    {
+        for (const BoardPos& tile : positions)
+        {
+            if (static_cast<size_t>(tile.x) >= puzzle.width || static_cast<size_t>(tile.y) >= puzzle.height)
+                Fail("target of " + puzzle.name + " is outside of its board");
+            if (puzzle.rows[static_cast<size_t>(tile.y)][static_cast<size_t>(tile.x)] == 'X')
+                Fail("target " + std::string{static_cast<char>('a' + tile.x)} + std::to_string(tile.y + 1) + " of " + puzzle.name + " is on a BLOCKED tile");
+            bool& isListed = isTarget[static_cast<size_t>(tile.y) * MAX_BOARD_SIZE + static_cast<size_t>(tile.x)];
+            if (isListed)
+                Fail("tile " + std::string{static_cast<char>('a' + tile.x)} + std::to_string(tile.y + 1) + " of " + puzzle.name + " is listed as a target more than once");
+            isListed = true;
+        }
+    }
+    return puzzle;
+}
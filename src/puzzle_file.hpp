@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+
+// Puzzle read at runtime, before its size is known at compile time (see DispatchPuzzle)
+struct PuzzleDescription {
+    std::string name;
+    size_t width = 0;
+    size_t height = 0;
+    // Tiles of each row, in the characters of boardStateMapping
+    std::vector<std::string> rows;
+    std::unordered_map<Target, std::vector<BoardPos>> targets;
+};
+
+// Streams puzzles from a text file, one block per puzzle:
+//
+//     puzzle King_E1
+//     |R B R|
+//     | YYY |
+//     |BXYXB|
+//     |XRYRX|
+//     |YYXYY|
+//     B c3 b4 d4
+//     R a2 e2 a5 e5
+//
+// Rows are enclosed in '|' so that EMPTY tiles at either end survive editors stripping whitespace. Targets are
+// written the way moves are printed (column letter, then row number from 1 at the top). Blank lines and lines
+// starting with '#' are ignored.
+class PuzzleReader {
+public:
+    explicit PuzzleReader(const std::string& path);
+
+    // Returns the next puzzle of the file, or std::nullopt once all of them were read. Exits on malformed puzzles
+    std::optional<PuzzleDescription> Next();
+
+private:
+    // Reads the next line which isn't blank or a comment into mLine, returns false at the end of the file
+    bool ReadLine();
+    [[noreturn]] void Fail(const std::string& message) const;
+
+    std::string mPath;
+    std::ifstream mFile;
+    std::string mLine;
+    size_t mLineNumber = 0;
+    bool mHasLine = false;
+};
@@ -1,123 +1,169 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
+#include <array>
+#include <initializer_list>
+#include <type_traits>
 
 #include "common.hpp"
 #include "board.hpp"
+#include "targets.hpp"
 
+// List of at most Capacity values, which unlike a std::vector can be part of a constexpr object
+template <typename T, size_t Capacity>
+class FixedList {
+public:
+    constexpr FixedList() = default;
+    constexpr FixedList(std::initializer_list<T> values)
+    {
+        for (const T& value : values)
+        {
+            push_back(value);
+        }
+    }
+
+    constexpr void push_back(const T& value) { mValues[mSize++] = value; }
+    constexpr size_t size() const { return mSize; }
+    constexpr const T* begin() const { return mValues.data(); }
+    constexpr const T* end() const { return mValues.data() + mSize; }
+
+private:
+    std::array<T, Capacity> mValues{};
+    size_t mSize = 0;
+};
+
+// Puzzles only hold fixed-size members, so they can be declared constexpr and their BLOCKED tiles used at compile
+// time (see StaticLayoutOf)
 template <size_t Width, size_t Height>
 struct Puzzle {
+    static constexpr size_t kWidth = Width;
+    static constexpr size_t kHeight = Height;
+
+    struct TargetTiles {
+        Target target;
+        FixedList<BoardPos, Width * Height> tiles;
+    };
+
     std::array<std::array<char, Width>, Height> initialState;
-    std::unordered_map<Target, std::vector<BoardPos>> targets;
+    FixedList<TargetTiles, Targets<Width, Height>::kNOfTargets> targets;
+
+    // Targets in the form taken by the Targets constructor
+    typename Targets<Width, Height>::TargetMap TargetMap() const
+    {
+        typename Targets<Width, Height>::TargetMap map;
+        for (const TargetTiles& entry : targets)
+        {
+            map[entry.target].assign(entry.tiles.begin(), entry.tiles.end());
+        }
+        return map;
+    }
 };
 
 namespace Puzzles {
 
-// Solves in 2 iterations (2ms)
+// Solves in 2 iterations (<1ms)
 // 2 moves: a3->b1, b1->c3
-Puzzle<3, 3> Pawn_A1 {
+inline constexpr Puzzle<3, 3> Pawn_A1 {
     .initialState{{
         {' ', ' ', ' '},
         {' ', 'X', 'X'},
         {'B', 'X', ' '}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{2, 2}}}
-    }}
+    }
 };
 
-// Solves in 2 iterations (2ms)
+// Solves in 2 iterations (<1ms)
 // 2 moves: c1->b3, a3->b1
-Puzzle<3, 3> Pawn_C1 {
+inline constexpr Puzzle<3, 3> Pawn_C1 {
     .initialState{{
         {' ', ' ', 'R'},
         {'X', 'X', 'X'},
         {'B', ' ', ' '}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{1, 0}}},
         {Target::RED, {{1, 2}}}
-    }}
+    }
 };
 
-// Solves in 11 iterations (2ms)
+// Solves in 11 iterations (<1ms)
 // 8 moves: c1->b3, a3->b1, b1->c3, c3->a2, a2->c1, b3->a1, a1->c2, c2->a3
-Puzzle<3, 3> Pawn_C2 {
+inline constexpr Puzzle<3, 3> Pawn_C2 {
     .initialState{{
         {' ', ' ', 'R'},
         {' ', 'X', ' '},
         {'B', ' ', ' '}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{2, 0}}},
         {Target::RED, {{0, 2}}}
-    }}
+    }
 };
 
-// Solves in 208 iterations (4ms)
+// Solves in 47 iterations (<1ms)
 // 8 moves: a1->b3, c1->a2, a3->c2, c3->a4, a2->c3, c3->b1, a4->c3, c3->a2
-Puzzle<3, 4> Rook_A1 {
+inline constexpr Puzzle<3, 4> Rook_A1 {
     .initialState{{
         {'B', ' ', 'B'},
         {' ', ' ', ' '},
         {'R', ' ', 'R'},
         {' ', 'X', ' '}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{1, 0}, {1, 2}}},
         {Target::RED, {{0, 1}, {2, 1}}}
-    }}
+    }
 };
 
-// Solves in 70 iterations (2ms)
+// Solves in 55 iterations (<1ms)
 // 8 moves: c1->a2, a2->c3, b1->a3, a3->c2, c3->b1, b1->a3, a4->c3, c3->b1
-Puzzle<3, 4> Rook_C4 {
+inline constexpr Puzzle<3, 4> Rook_C4 {
     .initialState{{
         {'X', 'R', 'B'},
         {' ', 'X', ' '},
         {' ', 'X', ' '},
         {'R', 'B', 'X'}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{0, 2}, {1, 3}}},
         {Target::RED, {{1, 0}, {2, 1}}}
-    }}
+    }
 };
 
-// Solves in 5351 iterations (17ms)
+// Solves in 1777 iterations (2ms)
 // 14 moves: d4->b3, a2->b4, d3->c1, c1->a2, b4->d3, b3->d2, a1->b3, b1->a3, d2->b1, c4->d2, a3->c4, b3->d4, d2->b3, b3->a1
-Puzzle<4, 4> Bishop_A1 {
+inline constexpr Puzzle<4, 4> Bishop_A1 {
     .initialState{{
         {'R', 'R', ' ', ' '},
         {'R', 'X', 'X', ' '},
         {' ', ' ', 'X', 'B'},
         {' ', ' ', 'B', 'B'}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{0, 0}, {1, 0}, {0, 1}}},
         {Target::RED, {{3, 2}, {2, 3}, {3, 3}}}
-    }}
+    }
 };
 
-// Solves in 9507 iterations (31ms)
+// Solves in 2946 iterations (4ms)
 // 21 moves: c2->a3, b2->c4, a4->b2, c3->a2, a3->b1, b1->c3, a1->c2, c2->a3, b3->d4, a3->b1, d4->c2, c2->a3, c3->a4, b1->c3, a3->b1, c4->a3, b2->c4, a4->b2, c3->a4, b1->c3, a3->b1
-Puzzle<4, 4> Bishop_D4 {
+inline constexpr Puzzle<4, 4> Bishop_D4 {
     .initialState{{
         {'R', ' ', 'X', ' '},
         {' ', 'B', 'R', 'X'},
         {' ', 'R', 'B', 'X'},
         {'B', 'X', ' ', ' '}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{1, 0}, {0, 1}, {2, 3}}},
         {Target::RED, {{1, 1}, {2, 2}, {0, 3}}}
-    }}
+    }
 };
 
-// Solves in 26532 iterations (176ms)
+// Solves in 295 iterations (<1ms)
 // 16 moves: b1->a3, c1->d3, d5->c3, c3->b1, d1->c3, c3->d5, b5->c3, a3->b5, c3->d1, a5->b3, b3->c1, a1->b3, b3->a5, c5->b3, d3->c5, b3->a1
-Puzzle<4, 5> Queen_A1 {
+inline constexpr Puzzle<4, 5> Queen_A1 {
     .initialState{{
         {'R', 'R', 'R', 'R'},
         {' ', 'X', 'X', 'X'},
@@ -125,14 +171,15 @@ Puzzle<4, 5> Queen_A1 {
         {'X', 'X', 'X', ' '},
         {'B', 'B', 'B', 'B'}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{0, 0}, {1, 0}, {2, 0}, {3, 0}}},
         {Target::RED, {{0, 4}, {1, 4}, {2, 4}, {3, 4}}}
-    }}
+    }
 };
 
-// Currently too hard to solve (3.5M+ iterations - runs out of RAM)
-Puzzle<5, 5> King_E1 {
+// Solves in 3515397 iterations (~8s, 362MB peak RSS)
+// 27 moves: d4->e2, c3->d1, c1->a2, a2->c3, b4->a2, c2->b4, e3->c2, c2->d4, e1->c2, c2->e3, b4->c2, c2->e1, a3->c2, c2->b4, a1->c2, c4->a3, a5->c4, a3->b1, c4->a3, e3->c4, c4->a5, e5->c4, c2->e3, a3->c2, c4->a3, e3->c4, c4->e5
+inline constexpr Puzzle<5, 5> King_E1 {
     .initialState{{
         {'R', ' ', 'B', ' ', 'R'},
         {' ', 'Y', 'Y', 'Y', ' '},
@@ -140,10 +187,30 @@ Puzzle<5, 5> King_E1 {
         {'X', 'R', 'Y', 'R', 'X'},
         {'Y', 'Y', 'X', 'Y', 'Y'}
     }},
-    .targets{{
+    .targets{
         {Target::BLUE, {{2, 2}, {1, 3}, {3, 3}}},
-        {Target::RED, {{0, 1}, {4, 1}, {0, 4}, {4, 4}}},
-    }}
+        {Target::RED, {{0, 1}, {4, 1}, {0, 4}, {4, 4}}}
+    }
 };
 
+// Layout policy of the boards of a constexpr puzzle, with its BLOCKED tiles fixed at compile time
+template <const auto& puzzle>
+using StaticLayoutOf = StaticLayout<std::remove_cvref_t<decltype(puzzle)>::kWidth, std::remove_cvref_t<decltype(puzzle)>::kHeight, BlockedTilesOf(puzzle.initialState)>;
+
+// Calls func.template operator()<StaticLayoutOf<puzzle>>(name, puzzle) on every puzzle above, in the order they are
+// defined. New puzzles must be added here to be picked up by the benchmarks
+template <typename Func>
+void ForEachPuzzle(Func&& func)
+{
+    func.template operator()<StaticLayoutOf<Pawn_A1>>("Pawn_A1", Pawn_A1);
+    func.template operator()<StaticLayoutOf<Pawn_C1>>("Pawn_C1", Pawn_C1);
+    func.template operator()<StaticLayoutOf<Pawn_C2>>("Pawn_C2", Pawn_C2);
+    func.template operator()<StaticLayoutOf<Rook_A1>>("Rook_A1", Rook_A1);
+    func.template operator()<StaticLayoutOf<Rook_C4>>("Rook_C4", Rook_C4);
+    func.template operator()<StaticLayoutOf<Bishop_A1>>("Bishop_A1", Bishop_A1);
+    func.template operator()<StaticLayoutOf<Bishop_D4>>("Bishop_D4", Bishop_D4);
+    func.template operator()<StaticLayoutOf<Queen_A1>>("Queen_A1", Queen_A1);
+    func.template operator()<StaticLayoutOf<King_E1>>("King_E1", King_E1);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "record_file.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+namespace {
+// Records are read and written in blocks of at least this many bytes
+constexpr size_t kBlockBytes = size_t{1} << 20;
+}
+
+RecordWriter::RecordWriter(const std::string& path, size_t recordSize)
+    : mPath(path), mFile(std::fopen(path.c_str(), "wb")), mRecordSize(recordSize),
+      mBuffer(std::max<size_t>(kBlockBytes / recordSize, 1) * recordSize)
+{
+    if (!mFile)
+    {
+        std::cerr << "[Error] Unable to open " << mPath << " for writing" << std::endl;
+        exit(1);
+    }
+}
+
+RecordWriter::~RecordWriter()
+{
+    if (mFile)
+        Close();
+}
+
+void RecordWriter::Write(const void* record)
+{
+    std::copy_n(static_cast<const char*>(record), mRecordSize, mBuffer.data() + mBuffered);
+    mBuffered += mRecordSize;
+    mRecords++;
+    if (mBuffered == mBuffer.size())
+        FlushBuffer();
+}
+
+void RecordWriter::Close()
+{
+    FlushBuffer();
+    if (std::fclose(mFile) != 0)
+    {
+        std::cerr << "[Error] Unable to close " << mPath << std::endl;
+        exit(1);
+    }
+    mFile = nullptr;
+}
+
+void RecordWriter::FlushBuffer()
+{
+    if (mBuffered && std::fwrite(mBuffer.data(), 1, mBuffered, mFile) != mBuffered)
+    {
+        std::cerr << "[Error] Unable to write to " << mPath << " (out of disk space?)" << std::endl;
+        exit(1);
+    }
+    mBuffered = 0;
+}
+
+RecordReader::RecordReader(const std::string& path, size_t recordSize)
+    : mPath(path), mFile(std::fopen(path.c_str(), "rb")), mRecordSize(recordSize), mRecords(0),
+      mBuffer(std::max<size_t>(kBlockBytes / recordSize, 1) * recordSize)
+{
+    if (!mFile || std::fseek(mFile, 0, SEEK_END) != 0)
+    {
+        std::cerr << "[Error] Unable to open " << mPath << " for reading" << std::endl;
+        exit(1);
+    }
+    mRecords = static_cast<uint64_t>(std::ftell(mFile)) / mRecordSize;
+    std::rewind(mFile);
+}
+
+RecordReader::~RecordReader()
+{
+    std::fclose(mFile);
+}
+
+const void* RecordReader::Next()
+{
+    if (mPosition == mBuffered)
+    {
+        if (mNextRecord == mRecords)
+            return nullptr;
+
+        // ReadAt may have moved the file position, so always seek to where the sequential reads left off
+        std::fseek(mFile, static_cast<long>(mNextRecord * mRecordSize), SEEK_SET);
+        size_t toRead = static_cast<size_t>(std::min<uint64_t>(mBuffer.size() / mRecordSize, mRecords - mNextRecord)) * mRecordSize;
+        if (std::fread(mBuffer.data(), 1, toRead, mFile) != toRead)
+        {
+            std::cerr << "[Error] Unable to read from " << mPath << std::endl;
+            exit(1);
+        }
+        mBuffered = toRead;
+        mPosition = 0;
+    }
+
+    const void* record = mBuffer.data() + mPosition;
+    mPosition += mRecordSize;
+    mNextRecord++;
+    return record;
+}
+
+void RecordReader::ReadAt(uint64_t index, void* record)
+{
+    if (std::fseek(mFile, static_cast<long>(index * mRecordSize), SEEK_SET) != 0 || std::fread(record, 1, mRecordSize, mFile) != mRecordSize)
+    {
+        std::cerr << "[Error] Unable to read record " << index << " from " << mPath << std::endl;
+        exit(1);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Buffered, sequential writer for files of fixed-size records. Records are written with large block writes so
+// ExternalSolver's open and closed lists stream to disk at sequential bandwidth.
+class RecordWriter {
+public:
+    RecordWriter(const std::string& path, size_t recordSize);
+    ~RecordWriter();
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    void Write(const void* record);
+    // Writes out every buffered record and closes the file, after which the writer can't be used anymore
+    void Close();
+
+    // Number of records written since the file was opened
+    uint64_t size() const { return mRecords; }
+
+private:
+    void FlushBuffer();
+
+    std::string mPath;
+    std::FILE* mFile;
+    size_t mRecordSize;
+    std::vector<char> mBuffer;
+    size_t mBuffered = 0;
+    uint64_t mRecords = 0;
+};
+
+// Buffered reader for files written by RecordWriter. Supports both sequential reads and random access by record
+// index (used to binary search sorted files).
+class RecordReader {
+public:
+    RecordReader(const std::string& path, size_t recordSize);
+    ~RecordReader();
+    RecordReader(const RecordReader&) = delete;
+    RecordReader& operator=(const RecordReader&) = delete;
+
+    // Returns the next record, or nullptr once every record has been read. The record stays valid until the next call
+    const void* Next();
+    // Reads the record at index into record, independently of the sequential position
+    void ReadAt(uint64_t index, void* record);
+
+    uint64_t size() const { return mRecords; }
+
+private:
+    std::string mPath;
+    std::FILE* mFile;
+    size_t mRecordSize;
+    uint64_t mRecords;
+    std::vector<char> mBuffer;
+    size_t mBuffered = 0;
+    size_t mPosition = 0;
+    uint64_t mNextRecord = 0;
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#if defined(STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+// Nodes are counted per f-cost up to this cost, more expensive nodes are counted in the last layer
+static constexpr size_t kMaxStatsCostLayers = 128;
+
+// Snapshot of the work done by a search, for reporting and benchmarking. The fields after filteredNodes are only
+// filled in when built with STATS (make STATS=1)
+struct SearchStats {
+    uint64_t expandedNodes = 0;
+    uint64_t generatedNodes = 0;
+    // Generated nodes dropped because their board was already reached in as few moves
+    uint64_t filteredNodes = 0;
+    uint64_t openNodes = 0;
+
+    // Generated nodes whose board was already closed, and open nodes replaced by a node reaching the same board in
+    // fewer moves
+    uint64_t closedSetHits = 0;
+    uint64_t openSetReplacements = 0;
+    // Time spent (in time-stamp counter cycles) applying moves along with their heuristic cost, canonicalising, hashing
+    // and looking boards up in the node table, generating moves, and pushing to/popping from the open list
+    uint64_t heuristicCycles = 0;
+    uint64_t hashingCycles = 0;
+    uint64_t moveGenerationCycles = 0;
+    uint64_t queueCycles = 0;
+    std::array<uint64_t, kMaxStatsCostLayers> expandedPerCost{};
+};
+
+// Counter updated by a single search thread while a StatsReporter may read it from another. Only the owning thread
+// writes it, so a relaxed load and store (plain moves on x86) are enough, no atomic read-modify-write is needed
+class StatCounter {
+public:
+    void Add(uint64_t n = 1) { mValue.store(mValue.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void Set(uint64_t value) { mValue.store(value, std::memory_order_relaxed); }
+    uint64_t Get() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> mValue{0};
+};
+
+// Live counters of a search, see SearchStats for their meaning
+struct SearchCounters {
+    StatCounter expandedNodes;
+    StatCounter generatedNodes;
+    StatCounter filteredNodes;
+    StatCounter openNodes;
+
+    StatCounter closedSetHits;
+    StatCounter openSetReplacements;
+    StatCounter heuristicCycles;
+    StatCounter hashingCycles;
+    StatCounter moveGenerationCycles;
+    StatCounter queueCycles;
+    std::array<StatCounter, kMaxStatsCostLayers> expandedPerCost;
+
+    StatCounter& ExpandedWithCost(uint32_t cost) { return expandedPerCost[cost < kMaxStatsCostLayers ? cost : kMaxStatsCostLayers - 1]; }
+
+    // Sets every counter to the values of stats, e.g. when resuming a search from a checkpoint
+    void Restore(const SearchStats& stats)
+    {
+        expandedNodes.Set(stats.expandedNodes);
+        generatedNodes.Set(stats.generatedNodes);
+        filteredNodes.Set(stats.filteredNodes);
+        openNodes.Set(stats.openNodes);
+        closedSetHits.Set(stats.closedSetHits);
+        openSetReplacements.Set(stats.openSetReplacements);
+        heuristicCycles.Set(stats.heuristicCycles);
+        hashingCycles.Set(stats.hashingCycles);
+        moveGenerationCycles.Set(stats.moveGenerationCycles);
+        queueCycles.Set(stats.queueCycles);
+        for (size_t cost = 0; cost < kMaxStatsCostLayers; cost++)
+        {
+            expandedPerCost[cost].Set(stats.expandedPerCost[cost]);
+        }
+    }
+
+    SearchStats Snapshot() const
+    {
+        SearchStats stats;
+        stats.expandedNodes = expandedNodes.Get();
+        stats.generatedNodes = generatedNodes.Get();
+        stats.filteredNodes = filteredNodes.Get();
+        stats.openNodes = openNodes.Get();
+        stats.closedSetHits = closedSetHits.Get();
+        stats.openSetReplacements = openSetReplacements.Get();
+        stats.heuristicCycles = heuristicCycles.Get();
+        stats.hashingCycles = hashingCycles.Get();
+        stats.moveGenerationCycles = moveGenerationCycles.Get();
+        stats.queueCycles = queueCycles.Get();
+        for (size_t cost = 0; cost < kMaxStatsCostLayers; cost++)
+        {
+            stats.expandedPerCost[cost] = expandedPerCost[cost].Get();
+        }
+        return stats;
+    }
+};
+
+#ifdef STATS
+// Adds the time-stamp counter cycles elapsed during its lifetime to a counter
+class ScopedCycleTimer {
+public:
+    explicit ScopedCycleTimer(StatCounter& counter) : mCounter(counter), mStart(Now()) {}
+    ~ScopedCycleTimer() { mCounter.Add(Now() - mStart); }
+
+    ScopedCycleTimer(const ScopedCycleTimer&) = delete;
+    ScopedCycleTimer& operator=(const ScopedCycleTimer&) = delete;
+
+private:
+    static uint64_t Now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    StatCounter& mCounter;
+    uint64_t mStart;
+};
+
+#define STATS_CONCAT_INNER(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_INNER(a, b)
+// Instrumentation only compiled in with STATS, so it costs nothing otherwise
+#define STATS_ADD(counter, n) (counter).Add(n)
+#define STATS_TIMER(counter) ScopedCycleTimer STATS_CONCAT(statsTimer, __LINE__)(counter)
+#else
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_TIMER(counter) ((void)0)
+#endif
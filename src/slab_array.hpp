@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+
+// Growable array of trivially copyable elements stored in fixed-size slabs of 2^SlabBits elements. Unlike a
+// std::vector it never reallocates: growing adds a slab, so elements don't move, there's no moment where the old and
+// new buffers are both alive, and at most one slab is unused. Slabs are only freed when the array is destroyed, in one
+// go.
+template <typename T, size_t SlabBits = 16>
+class SlabArray {
+public:
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+    static constexpr size_t kSlabSize = size_t{1} << SlabBits;
+
+    T& operator[](size_t index) { return Slab(index >> SlabBits)[index & kSlabMask]; }
+    const T& operator[](size_t index) const { return Slab(index >> SlabBits)[index & kSlabMask]; }
+
+    void push_back(const T& value)
+    {
+        if (mSize == capacity())
+            mSlabs.push_back(std::unique_ptr<Storage>(new Storage));
+        new (&(*this)[mSize]) T(value);
+        mSize++;
+    }
+
+    // Allocates the slabs needed to hold nOfElements elements up front
+    void reserve(size_t nOfElements)
+    {
+        while (capacity() < nOfElements)
+            mSlabs.push_back(std::unique_ptr<Storage>(new Storage));
+    }
+    // Forgets every element but keeps the slabs
+    void clear() { mSize = 0; }
+
+    size_t size() const { return mSize; }
+    size_t capacity() const { return mSlabs.size() * kSlabSize; }
+    size_t NOfSlabs() const { return mSlabs.size(); }
+    size_t BytesUsed() const { return mSlabs.size() * sizeof(Storage) + mSlabs.capacity() * sizeof(mSlabs[0]); }
+
+private:
+    static constexpr size_t kSlabMask = kSlabSize - 1;
+
+    // Left uninitialised, so pages of a slab are only touched once elements are added to them
+    struct Storage {
+        alignas(T) std::byte bytes[kSlabSize * sizeof(T)];
+    };
+
+    T* Slab(size_t slab) const { return std::launder(reinterpret_cast<T*>(mSlabs[slab]->bytes)); }
+
+    std::vector<std::unique_ptr<Storage>> mSlabs;
+    size_t mSize = 0;
+};
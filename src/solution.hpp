@@ -7,35 +7,58 @@
 #include "common.hpp"
 #include "board.hpp"
 
-template <size_t Width, size_t Height>
+template <size_t Width, size_t Height, typename LayoutPolicy = RuntimeLayout<Width, Height>>
 struct Solution {
-    Board<Width, Height> board;
+    Board<Width, Height, LayoutPolicy> board;
     std::vector<Move> moves;
     uint32_t heuristicCost;
 
-    Solution(Board<Width, Height>&& board, const std::unordered_map<Target, std::vector<BoardPos>>& targets)
+    Solution(Board<Width, Height, LayoutPolicy>&& board, const Targets<Width, Height>& targets)
         : board(board), moves{}, heuristicCost(board.GetHeuristicCost(targets))
     {}
 
+    Solution(const Board<Width, Height, LayoutPolicy>& board, std::vector<Move>&& moves, uint32_t heuristicCost)
+        : board(board), moves(std::move(moves)), heuristicCost(heuristicCost)
+    {}
+
     uint32_t GetTotalCost() const { return NOfMoves() + heuristicCost; }
     uint32_t NOfMoves() const { return static_cast<uint32_t>(moves.size()); }
-    bool IsComplete(const std::unordered_map<Target, std::vector<BoardPos>>& targets) { return board.IsSolved(targets); }
+    bool IsComplete(const Targets<Width, Height>& targets) { return board.IsSolved(targets); }
 
-    void ApplyMove(Move&& move, const std::unordered_map<Target, std::vector<BoardPos>>& targets);
+    void ApplyMove(Move&& move, const Targets<Width, Height>& targets);
+    // Reverts the most recently applied move, allowing a single Solution to be used as a depth-first search path
+    void UndoMove(const Targets<Width, Height>& targets);
 };
 
-template <size_t W, size_t H>
-void Solution<W, H>::ApplyMove(Move&& move, const std::unordered_map<Target, std::vector<BoardPos>>& targets)
+// Applies move to board, incrementally updating heuristicCost (only the moved knight's cost can change, except for
+// pattern database costs, which depend on where every knight is and are looked up again)
+template <size_t W, size_t H, typename L>
+void ApplyMoveWithHeuristic(Board<W, H, L>& board, uint32_t& heuristicCost, const Move& move, const Targets<W, H>& targets)
 {
-    uint32_t oldHeuristicCost = board.GetTileHeuristicCost(move.start, targets);
+    bool isPatternDatabase = targets.Mode() == HeuristicMode::PATTERN_DATABASE;
+    uint32_t oldHeuristicCost = board.GetTileHeuristicCost(move.start, targets) + (isPatternDatabase ? board.GetColourHeuristicCost(targets) : 0);
     board.ApplyMove(move);
-    uint32_t newHeuristicCost = board.GetTileHeuristicCost(move.end, targets);
+    uint32_t newHeuristicCost = board.GetTileHeuristicCost(move.end, targets) + (isPatternDatabase ? board.GetColourHeuristicCost(targets) : 0);
     heuristicCost += newHeuristicCost - oldHeuristicCost;
+}
+
+template <size_t W, size_t H, typename L>
+void Solution<W, H, L>::ApplyMove(Move&& move, const Targets<W, H>& targets)
+{
+    ApplyMoveWithHeuristic(board, heuristicCost, move, targets);
     moves.push_back(move);
 }
 
-template <size_t W, size_t H>
-std::ostream& operator<<(std::ostream& os, const Solution<W, H>& soln)
+template <size_t W, size_t H, typename L>
+void Solution<W, H, L>::UndoMove(const Targets<W, H>& targets)
+{
+    Move lastMove = moves.back();
+    moves.pop_back();
+    ApplyMoveWithHeuristic(board, heuristicCost, Move{lastMove.end, lastMove.start}, targets);
+}
+
+template <size_t W, size_t H, typename L>
+std::ostream& operator<<(std::ostream& os, const Solution<W, H, L>& soln)
 {
     os << soln.NOfMoves() << " moves: ";
     for (auto it = soln.moves.begin(); it != soln.moves.end(); it++)
@@ -2,191 +2,675 @@
 
 #include <unordered_map>
 #include <vector>
-#include <set>
+#include <array>
 #include <cstdint>
-#include <unordered_set>
 #include <optional>
 #include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <string>
 
 #include "common.hpp"
 #include "board.hpp"
 #include "solution.hpp"
+#include "node_store.hpp"
+#include "symmetry.hpp"
+#include "bucket_queue.hpp"
+#include "node_table.hpp"
 #include "helper.hpp"
 #include "puzzles.hpp"
+#include "solver_options.hpp"
+#include "search_stats.hpp"
+#include "stats_reporter.hpp"
+#include "checkpoint.hpp"
 
-template <size_t Width, size_t Height>
+// LayoutPolicy decides how boards find their BoardLayout, a StaticLayout (see Puzzles::StaticLayoutOf) specialises
+// the search for the BLOCKED tiles of a constexpr puzzle
+template <size_t Width, size_t Height, typename LayoutPolicy = RuntimeLayout<Width, Height>>
 class Solver 
 {
 public:
-    Solver(Puzzle<Width, Height>&& puzzle)
-        : mTargets(std::move(puzzle.targets)),
-          mAvailableNodes(NodeOrder)
+    Solver(const Puzzle<Width, Height>& puzzle, const SolverOptions& options = {})
+        : mLog(options.isQuiet ? nullptr : std::cout.rdbuf()),
+          mTargets(puzzle.TargetMap(), Board<Width, Height, LayoutPolicy>(puzzle.initialState), options),
+          mSymmetry(Board<Width, Height, LayoutPolicy>(puzzle.initialState).GetLayout(), mTargets, options.useSymmetry, mLog),
+          mSolvedPattern(Board<Width, Height, LayoutPolicy>(puzzle.initialState).GetSolvedPattern(mTargets)),
+          mStatsPath(options.statsPath), mStatsInterval(options.statsIntervalMs),
+          mCheckpointPath(options.checkpointPath), mCheckpointInterval(options.checkpointIntervalSeconds),
+          mUsePartialExpansion(options.usePartialExpansion && !options.maxMemory)
     {
-        Solution<Width, Height> initialSoln(std::move(puzzle.initialState), mTargets);
-        InsertNode(std::move(initialSoln));
+        if (options.usePartialExpansion && options.maxMemory)
+            std::cerr << "[Warning] Partial expansion isn't supported by memory-bounded searches, expanding nodes in full" << std::endl;
+        if (options.maxMemory)
+            ReserveMemory(options.maxMemory);
+        Solution<Width, Height, LayoutPolicy> initialSoln(puzzle.initialState, mTargets);
+        InsertNode(NodeStore<Width, Height, LayoutPolicy>::MakeRoot(initialSoln, mSymmetry));
+        if (options.resume)
+            LoadCheckpoint();
     }
 
-    Solution<Width, Height> GenerateSolution(uint32_t maxIterations = 1000000);
+    // Exits if the puzzle can't be solved, TrySolve returns std::nullopt instead (FailureReason then says why)
+    Solution<Width, Height, LayoutPolicy> GenerateSolution(uint32_t maxIterations = 1000000);
+    std::optional<Solution<Width, Height, LayoutPolicy>> TrySolve(uint32_t maxIterations = 1000000);
+    const std::string& FailureReason() const { return mFailureReason; }
+    SearchStats Stats() const { return mStats.Snapshot(); }
     
 private:
-    static bool NodeOrder(const Solution<Width, Height>& l, const Solution<Width, Height>& r);
-
-    void InsertNode(Solution<Width, Height>&& solution); 
-    Solution<Width, Height> GetNextNode();
-    bool UpdateBestSolution(Solution<Width, Height>&& candidate);
-
-    std::unordered_map<Target, std::vector<BoardPos>> mTargets;
-    std::set<Solution<Width, Height>, decltype(&NodeOrder)> mAvailableNodes;
-    std::unordered_map<Board<Width, Height>, typename std::set<Solution<Width, Height>>::iterator> mNodeMap;
-    std::unordered_set<Board<Width, Height>> mExpandedNodes;
-    std::optional<Solution<Width, Height>> mBestSolution;
-    size_t mFilteredSolutions = 0;
+    using Node = SearchNode<Width, Height, LayoutPolicy>;
+
+    static constexpr uint64_t kCheckpointMagic = 0x3130305450434b53; // "SKCPT001"
+
+    // Bookkeeping for memory-bounded search, kept apart from the nodes so unbounded searches don't pay for it
+    struct PruneInfo {
+        static constexpr uint16_t kNoCost = UINT16_MAX;
+
+        uint16_t liveChildren = 0;         // Nodes in mNodes whose parent is this node
+        uint16_t forgottenCost = kNoCost;  // Lowest f-cost of the children pruned since this node was last expanded
+        uint16_t queuedCost = 0;           // f-cost of the node's live entry in mAvailableNodes
+        bool isSuperseded = false;         // Replaced in mNodeTable by a node reaching the same board in fewer moves
+        bool isFree = false;               // The slot was released, and will be reused by the next node added
+    };
+
+    // Children of the node being expanded, field by field. They're all generated first, then checked for a solution in
+    // a loop over their packed boards (which the compiler is free to vectorise), and their entries in mNodeTable are
+    // prefetched before the first one is inserted, so the cache misses of the lookups overlap rather than add up
+    struct ChildBatch {
+        static constexpr size_t kCapacity = Board<Width, Height, LayoutPolicy>::kMaxMoves;
+
+        size_t size = 0;
+        std::array<typename Board<Width, Height, LayoutPolicy>::PackedBoard, kCapacity> boards;
+        std::array<uint64_t, kCapacity> hashes;
+        std::array<uint16_t, kCapacity> heuristicCosts;
+        std::array<Move, kCapacity> moves;
+        std::array<uint8_t, kCapacity> symmetries;
+        std::array<bool, kCapacity> isSolved;
+    };
+
+    void InsertNode(Node&& node); 
+    // Adds the child reached by move to mChildren, board being its parent's board with move applied
+    void AddChild(Board<Width, Height, LayoutPolicy> board, uint32_t heuristicCost, const Move& move);
+    // Inserts every child in mChildren as a child of parent (keeping solutions aside), and empties it
+    void InsertChildren(uint32_t parent);
+    // Pops the next open node to expand, and the cost it was queued with
+    uint32_t GetNextNode(uint32_t& cost);
+    // PEA*: generates the children of the node whose f-cost is the cost it was queued with, and queues the node again
+    // with the lowest f-cost of the children left out (the node's stored f-cost is the cost of its queue entry)
+    void ExpandPartially(uint32_t index, uint32_t cost, const typename Board<Width, Height, LayoutPolicy>::Moves& moves);
+    void RequeueNode(uint32_t index, uint32_t cost);
+    void ReportMemoryUsage() const;
+    // Keeps candidate, whose board is solved, as the best solution if it's shorter than the current one. Returns
+    // whether it was kept
+    bool UpdateBestSolution(const Node& candidate);
+
+    bool IsMemoryBounded() const { return mMaxNodes != 0; }
+    void ReserveMemory(size_t maxMemory);
+    size_t BytesUsed() const;
+    uint32_t AddNode(const Node& node);
+    void FreeNode(uint32_t index);
+    void PushNode(uint32_t index, uint32_t cost);
+    // SMA*-style pruning, forgets nodes until the number of live nodes drops back under the budget: first the open
+    // leaves costing more than the next node to expand (worst first), backing their f-costs up into their parents,
+    // which are reopened so the forgotten subtrees are regenerated if the search ever gets that far. Then closed nodes
+    // without live children, which only cost duplicate detection
+    void PruneNodes();
+
+    // Checkpoints hold the whole search state, GenerateSolution carries on from the saved iteration after a load
+    void SaveCheckpoint(CheckpointWriter& writer) const;
+    void LoadCheckpoint();
+
+    // Progress is logged to std::cout, or nowhere if quiet
+    mutable std::ostream mLog;
+    Targets<Width, Height> mTargets;
+    Symmetry<Width, Height> mSymmetry;
+    typename Board<Width, Height, LayoutPolicy>::SolvedPattern mSolvedPattern;
+    NodeStore<Width, Height, LayoutPolicy> mNodes;
+    ChildBatch mChildren;
+    BucketQueue mAvailableNodes;
+    // Tracks every board seen so far, open entries hold the node live in mAvailableNodes (other entries are stale)
+    NodeTable mNodeTable;
+    size_t mOpenNodes = 0;
+    std::optional<uint32_t> mBestSolution;
+    SearchCounters mStats;
+    // File the stats are written to by a StatsReporter while searching, none if empty
+    std::string mStatsPath;
+    std::chrono::milliseconds mStatsInterval;
+    // File the search state is saved to every mCheckpointInterval seconds, none if empty
+    std::string mCheckpointPath;
+    uint32_t mCheckpointInterval;
+    uint32_t mIteration = 0;
+    std::string mFailureReason;
+    bool mUsePartialExpansion;
+
+    // Memory-bounded search, mMaxNodes is 0 when unbounded
+    size_t mMaxNodes = 0;
+    std::vector<PruneInfo> mPruneInfo;
+    // Next slot checked for a closed node without live children, these are swept round-robin
+    uint32_t mDeadNodeCursor = 0;
+    size_t mPrunedNodes = 0;
+    size_t mPeakBytesUsed = 0;
+    bool mIsOverBudget = false;
 };
 
-template <size_t W, size_t H>
-Solution<W, H> Solver<W, H>::GenerateSolution(uint32_t maxIterations)
+template <size_t W, size_t H, typename L>
+Solution<W, H, L> Solver<W, H, L>::GenerateSolution(uint32_t maxIterations)
+{
+    std::optional<Solution<W, H, L>> solution = TrySolve(maxIterations);
+    if (!solution)
+    {
+        std::cerr << "[Error] " << mFailureReason << std::endl;
+        exit(1);
+    }
+    return std::move(*solution);
+}
+
+template <size_t W, size_t H, typename L>
+std::optional<Solution<W, H, L>> Solver<W, H, L>::TrySolve(uint32_t maxIterations)
 {
-    std::cout << "[Info] Attempting to solve:\n" << mAvailableNodes.begin()->board << std::endl;
-    for (uint32_t i = 0; i < maxIterations; i++)
+    mLog << "[Info] Attempting to solve:\n" << mSymmetry.Apply(mSymmetry.Inverse(mNodes[0].symmetry), mNodes[0].board) << std::endl;
+    // Checking the initial board is enough: moves can be undone, so every board reached from it is dead exactly when
+    // it is, and a per-child check could never discard anything
+    if (mNodes[0].board.IsDead(mTargets))
     {
-        if (i % 10000 == 0)
-            std::cout << "[Info] Iteration " << i << ": # of pending nodes = " << mAvailableNodes.size() << ", # of filtered nodes = " << mFilteredSolutions << ", found solution = " << mBestSolution.has_value() << std::endl;
-        if (mAvailableNodes.empty())
+        mFailureReason = "Some knight-move component lacks knights of a colour for its targets, or has unfilled targets but no EMPTY tile, problem has no solution";
+        return std::nullopt;
+    }
+    std::optional<StatsReporter> reporter;
+    if (!mStatsPath.empty())
+        reporter.emplace(mStats, mStatsPath, mStatsInterval);
+    std::optional<CheckpointScheduler> checkpoints;
+    if (!mCheckpointPath.empty())
+    {
+        checkpoints.emplace(mCheckpointPath, mCheckpointInterval);
+        CheckpointScheduler::InstallStopHandler();
+    }
+    auto saveCheckpoint = [this](CheckpointWriter& writer) { SaveCheckpoint(writer); };
+    for (; mIteration < maxIterations; mIteration++)
+    {
+        // Checkpoints are taken between iterations, where the state is consistent
+        if (checkpoints && mIteration % 1024 == 0)
+        {
+            if (CheckpointScheduler::IsStopRequested())
+            {
+                checkpoints->WriteNow(saveCheckpoint);
+                mLog << "[Info] Stopped @ iteration " << mIteration << ", saved the search to " << mCheckpointPath << " (continue it with --resume)" << std::endl;
+                exit(1);
+            }
+            if (checkpoints->IsDue())
+                checkpoints->Start(saveCheckpoint);
+        }
+        if (mIteration % 10000 == 0)
+            mLog << "[Info] Iteration " << mIteration << ": # of pending nodes = " << mOpenNodes << ", # of filtered nodes = " << mStats.filteredNodes.Get() << ", found solution = " << mBestSolution.has_value() << '\n';
+        if (mOpenNodes == 0)
         {
             if (mBestSolution)
             {
-                std::cout << "[Info] Exhausted all possible nodes, found optimal solution, terminating @ iteration " << i << std::endl;
-                return *mBestSolution;
+                mLog << "[Info] Exhausted all possible nodes, found optimal solution, terminating @ iteration " << mIteration << std::endl;
+                ReportMemoryUsage();
+                return mNodes.ReconstructSolution(*mBestSolution, mSymmetry);
             }
 
-            std::cerr << "[Error] Out of nodes to expand (explored " << i << " states, filtered " << mFilteredSolutions << "), problem has no solution" << std::endl;
-            exit(1);
+            mFailureReason = "Out of nodes to expand (explored " + std::to_string(mIteration) + " states, filtered " + std::to_string(mStats.filteredNodes.Get()) + "), problem has no solution";
+            return std::nullopt;
         }
 
-        Solution currentNode(GetNextNode());
-        if (mBestSolution && mBestSolution->NOfMoves() <= currentNode.GetTotalCost())
+        // Leave room for every successor of the next node
+        if (IsMemoryBounded() && mNodes.NOfLiveNodes() + Board<W, H, L>::kMaxMoves > mMaxNodes)
+            PruneNodes();
+
+        // Nodes reopened after their children were pruned (or partially expanded) are queued with a larger cost than
+        // their own f-cost
+        uint32_t currentCost;
+        uint32_t currentIndex = GetNextNode(currentCost);
+        const Node& currentNode = mNodes[currentIndex];
+        if (mBestSolution && mNodes[*mBestSolution].NOfMoves() <= currentCost)
         {
-            std::cout << "[Info] Current node heuristic cost (" << currentNode.GetTotalCost() << ") exceeds bound of current solution (" << mBestSolution->NOfMoves() << "), terminating @ iteration " << i << std::endl;
-            return *mBestSolution;
+            mLog << "[Info] Current node heuristic cost (" << currentCost << ") exceeds bound of current solution (" << mNodes[*mBestSolution].NOfMoves() << "), terminating @ iteration " << mIteration << std::endl;
+            ReportMemoryUsage();
+            return mNodes.ReconstructSolution(*mBestSolution, mSymmetry);
         }
         
-        for (Move& move : currentNode.board.GetPossibleMoves())
+        mStats.expandedNodes.Add();
+        mStats.openNodes.Set(mOpenNodes);
+        STATS_ADD(mStats.ExpandedWithCost(currentCost), 1);
+        auto moves = [&] { STATS_TIMER(mStats.moveGenerationCycles); return currentNode.board.GetPossibleMoves(); }();
+        if (mUsePartialExpansion)
+        {
+            ExpandPartially(currentIndex, currentCost, moves);
+            continue;
+        }
+        for (const Move& move : moves)
         {
-            Solution candidate(currentNode);
-            candidate.ApplyMove(std::move(move), mTargets);
-            if (!UpdateBestSolution(std::move(candidate)))
+            mStats.generatedNodes.Add();
+            Board<W, H, L> board = currentNode.board;
+            uint32_t heuristicCost = currentNode.heuristicCost;
             {
-                InsertNode(std::move(candidate));
+                STATS_TIMER(mStats.heuristicCycles);
+                ApplyMoveWithHeuristic(board, heuristicCost, move, mTargets);
             }
+            AddChild(board, heuristicCost, move);
         }
+        InsertChildren(currentIndex);
     }
-    std::cerr << "[Error] Unable to find solution in " << maxIterations << " iterations, giving up." << std::endl;
-    exit(1);
+    mFailureReason = "Unable to find solution in " + std::to_string(maxIterations) + " iterations, giving up.";
+    return std::nullopt;
 }
 
-namespace {
-template <size_t W, size_t H>
-bool CompareBoardTiles(const Board<W, H>& l, const Board<W, H>& r)
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::ExpandPartially(uint32_t index, uint32_t cost, const typename Board<W, H, L>::Moves& moves)
 {
-    for (int8_t y = 0; y < l.board.height(); y++)
+    const Node& node = mNodes[index];
+    // Nodes are queued with a larger cost than their own f-cost only after their first expansion. Children cheaper than
+    // the node (when the heuristic is inconsistent) are generated on the first one
+    bool isFirstExpansion = cost == node.GetTotalCost();
+    uint32_t nextCost = UINT32_MAX;
+    for (const Move& move : moves)
     {
-        for (int8_t x = 0; x < l.board.width(); x++)
+        // Predicting the child's f-cost only takes the heuristic delta of the move, the child is canonicalised and
+        // looked up in mNodeTable only once it's generated
+        Board<W, H, L> board = node.board;
+        uint32_t heuristicCost = node.heuristicCost;
         {
-            BoardPos curr {x, y};
-            BoardState lState = l.board.at(curr);
-            BoardState rState = r.board.at(curr);
-            if (lState == rState)
-                continue;
-            
-            return static_cast<uint32_t>(lState) < static_cast<uint32_t>(rState);
+            STATS_TIMER(mStats.heuristicCycles);
+            ApplyMoveWithHeuristic(board, heuristicCost, move, mTargets);
         }
+        uint32_t childCost = node.NOfMoves() + 1 + heuristicCost;
+        if (childCost > cost)
+        {
+            nextCost = std::min(nextCost, childCost);
+            continue;
+        }
+        if (childCost < cost && !isFirstExpansion)
+            continue;
+
+        mStats.generatedNodes.Add();
+        AddChild(board, heuristicCost, move);
     }
+    InsertChildren(index);
+    if (nextCost != UINT32_MAX)
+        RequeueNode(index, nextCost);
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::RequeueNode(uint32_t index, uint32_t cost)
+{
+    // Looked up again rather than kept from GetNextNode, inserting the children may have grown mNodeTable
+    const Board<W, H, L>& nodeBoard = mNodes[index].board;
+    auto isMatch = [this, &nodeBoard](uint32_t other) { return mNodes[other].board == nodeBoard; };
+    NodeTable::Entry* entry = [&] { STATS_TIMER(mStats.hashingCycles); return mNodeTable.Find(nodeBoard.Hash(), isMatch); }();
+    entry->SetOpen(index);
+    PushNode(index, cost);
+    mOpenNodes++;
 }
-} // end of anonymous namespace
 
-template <size_t W, size_t H>
-bool Solver<W, H>::NodeOrder(const Solution<W, H>& l, const Solution<W, H>& r)
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::InsertNode(Node&& node)
 {
-    // We require NodeOrder(l, r) == NodeOrder(r, l) iff l == r
-    if (l.GetTotalCost() == r.GetTotalCost())
+    const Board<W, H, L>& nodeBoard = node.board;
+    auto isMatch = [this, &nodeBoard](uint32_t index) { return mNodes[index].board == nodeBoard; };
+    auto [entry, inserted] = [&] { STATS_TIMER(mStats.hashingCycles); return mNodeTable.FindOrInsert(nodeBoard.Hash(), isMatch); }();
+    if (!inserted)
     {
-        if (l.NOfMoves() == r.NOfMoves())
+        // Closed nodes were expanded through a shortest path, unless memory is bounded: the search may then have
+        // forgotten the board and reached it again through a longer path
+        if (entry->IsClosed() && !IsMemoryBounded())
         {
-            if constexpr(Board<W, H>::kHashOverflowPossible)
-            {
-                if (std::hash<Board<W, H>>()(l.board) == std::hash<Board<W, H>>()(r.board))
-                {
-                    return CompareBoardTiles(l, r);
-                }
-            }
-            return std::hash<Board<W, H>>()(l.board) < std::hash<Board<W, H>>()(r.board);
+            STATS_ADD(mStats.closedSetHits, 1);
+            mStats.filteredNodes.Add();
+            return;
+        }
+
+        const Node& existingNode = mNodes[entry->Node()];
+        bool isBetterSolution = node.NOfMoves() < existingNode.NOfMoves();
+        if (!isBetterSolution)
+        {
+            if (entry->IsClosed())
+                STATS_ADD(mStats.closedSetHits, 1);
+            mStats.filteredNodes.Add();
+            return;
+        }
+
+        // Solutions should have same heuristic cost since board states are identical
+        assert(node.GetTotalCost() < existingNode.GetTotalCost());
+        // The existing node's queue entry becomes stale once its handle is replaced below
+        if (!entry->IsClosed())
+        {
+            STATS_ADD(mStats.openSetReplacements, 1);
+            mOpenNodes--;
+        }
+        // The existing node is freed as soon as no other node refers to it
+        if (IsMemoryBounded())
+        {
+            mPruneInfo[entry->Node()].isSuperseded = true;
+            if (mPruneInfo[entry->Node()].liveChildren == 0)
+                FreeNode(entry->Node());
         }
-        return l.NOfMoves() > r.NOfMoves();
     }
-    return l.GetTotalCost() < r.GetTotalCost();
+
+    uint32_t index = AddNode(node);
+    entry->SetOpen(index);
+    PushNode(index, node.GetTotalCost());
+    mOpenNodes++;
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::AddChild(Board<W, H, L> board, uint32_t heuristicCost, const Move& move)
+{
+    // Canonicalising and hashing the child only serve to look it up in mNodeTable
+    STATS_TIMER(mStats.hashingCycles);
+    size_t i = mChildren.size++;
+    mChildren.symmetries[i] = mSymmetry.Canonicalise(board);
+    mChildren.boards[i] = board.GetPackedBoard();
+    mChildren.hashes[i] = board.Hash();
+    mChildren.heuristicCosts[i] = static_cast<uint16_t>(heuristicCost);
+    mChildren.moves[i] = move;
 }
 
-template <size_t W, size_t H>
-void Solver<W, H>::InsertNode(Solution<W, H>&& solution)
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::InsertChildren(uint32_t parent)
 {
-    Board solutionBoard = solution.board;
-    if (mExpandedNodes.contains(solutionBoard))
+    ChildBatch& children = mChildren;
+    for (size_t i = 0; i < children.size; i++)
     {
-        mFilteredSolutions++;
-        return;
+        children.isSolved[i] = Board<W, H, L>::IsSolved(children.boards[i], mSolvedPattern);
     }
-    
-    if (mNodeMap.contains(solutionBoard))
     {
-        bool isBetterSolution = solution.NOfMoves() < mNodeMap.at(solutionBoard)->NOfMoves();
-        if (!isBetterSolution)
+        STATS_TIMER(mStats.hashingCycles);
+        for (size_t i = 0; i < children.size; i++)
         {
-            mFilteredSolutions++;
-            return;
+            mNodeTable.Prefetch(children.hashes[i]);
         }
+    }
 
-        // Solutions should have same heuristic cost since board states are identical
-        assert(solution.GetTotalCost() < mNodeMap.at(solutionBoard)->GetTotalCost());
-        mAvailableNodes.erase(mNodeMap.at(solutionBoard));
-        mNodeMap.erase(solutionBoard);
+    const BoardLayout<W, H>& layout = mNodes[parent].board.GetLayout();
+    uint16_t nOfMoves = static_cast<uint16_t>(mNodes[parent].nOfMoves + 1);
+    for (size_t i = 0; i < children.size; i++)
+    {
+        Node child{Board<W, H, L>(layout, children.boards[i], children.hashes[i]), parent, children.moves[i], nOfMoves, children.heuristicCosts[i], children.symmetries[i]};
+        if (!children.isSolved[i] || !UpdateBestSolution(child))
+            InsertNode(std::move(child));
     }
+    children.size = 0;
+}
 
-    auto [it, setRes] = mAvailableNodes.insert(std::move(solution));
-    if (!setRes)
+template <size_t W, size_t H, typename L>
+uint32_t Solver<W, H, L>::GetNextNode(uint32_t& cost)
+{
+    // mOpenNodes is non-zero, so mAvailableNodes contains at least one live entry
+    while (true)
     {
-        std::cerr << "[Error] Unable to insert solution into mAvailableNodes (should be impossible)" << std::endl;
-        std::cerr << "Tried to insert solution with board state:\n" << solutionBoard << "\ntotal cost = " << solution.GetTotalCost() << ", # of moves = " << solution.NOfMoves() << ", board hash = " << std::hash<Board<W, H>>()(solutionBoard) << std::endl;
-        std::cerr << "Insertion was prevented by solution with board state:\n" << it->board << "\ntotal cost = " << it->GetTotalCost() << ", # of moves = " << it->NOfMoves() << ", board hash = " << std::hash<Board<W, H>>()(it->board) << std::endl;
-        exit(1);
+        uint32_t top;
+        {
+            STATS_TIMER(mStats.queueCycles);
+            cost = mAvailableNodes.MinCost();
+            top = mAvailableNodes.Pop();
+        }
+        // Slots of pruned nodes are reused, so when memory is bounded a stale entry may refer to a different node (or
+        // to a slot which is free), in which case its cost won't match the one the node was last queued with
+        if (IsMemoryBounded() && mPruneInfo[top].queuedCost != cost)
+            continue;
+
+        const Board<W, H, L>& topBoard = mNodes[top].board;
+        auto isMatch = [this, &topBoard](uint32_t index) { return mNodes[index].board == topBoard; };
+        NodeTable::Entry* entry = [&] { STATS_TIMER(mStats.hashingCycles); return mNodeTable.Find(topBoard.Hash(), isMatch); }();
+        if (!entry && !IsMemoryBounded())
+        {
+            std::cerr << "[Error] Node popped from mAvailableNodes is missing from mNodeTable (should be impossible)" << std::endl;
+            exit(1);
+        }
+        if (!entry || entry->IsClosed() || entry->Node() != top)
+            continue;
+
+        entry->SetClosed();
+        mOpenNodes--;
+        if (IsMemoryBounded())
+            mPruneInfo[top].forgottenCost = PruneInfo::kNoCost;
+        return top;
     }
-    auto [_, mapRes] = mNodeMap.emplace(std::move(solutionBoard), it);
-    if (!mapRes)
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::ReportMemoryUsage() const
+{
+    size_t states = mNodeTable.size();
+    mLog << "[Info] Stored " << states << " states: " << sizeof(Node) << " bytes/node in mNodes ("
+              << mNodes.size() << " nodes), " << static_cast<double>(mNodeTable.BytesUsed()) / static_cast<double>(states)
+              << " bytes/state in mNodeTable (mean probe length = " << mNodeTable.MeanProbeLength() << ')' << std::endl;
+    mLog << "[Info] Memory held: " << mNodes.BytesUsed() / (1024 * 1024) << "MB by mNodes (" << mNodes.NOfSlabs() << " slabs), "
+              << mNodeTable.BytesUsed() / (1024 * 1024) << "MB by mNodeTable, " << mAvailableNodes.BytesUsed() / (1024 * 1024)
+              << "MB by mAvailableNodes (" << mAvailableNodes.NOfBlocks() << " blocks, " << mAvailableNodes.NOfFreeBlocks() << " free), "
+              << mPruneInfo.capacity() * sizeof(PruneInfo) / (1024 * 1024) << "MB by mPruneInfo" << std::endl;
+    if (IsMemoryBounded())
+        mLog << "[Info] Pruned " << mPrunedNodes << " nodes to stay within the memory budget (" << mMaxNodes << " live nodes, peak of "
+                  << std::max(mPeakBytesUsed, BytesUsed()) / (1024 * 1024) << "MB used by the open and closed lists)" << std::endl;
+}
+
+template <size_t W, size_t H, typename L>
+bool Solver<W, H, L>::UpdateBestSolution(const Node& candidate)
+{
+    bool isBetterSolution = !mBestSolution || candidate.NOfMoves() < mNodes[*mBestSolution].NOfMoves();
+    if (!isBetterSolution)
+        return false;
+
+    // The previous solution is never used again, but its node (like the new one) keeps its ancestors live
+    if (mBestSolution && IsMemoryBounded())
+        FreeNode(*mBestSolution);
+    mBestSolution = AddNode(candidate);
+    return true;
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::ReserveMemory(size_t maxMemory)
+{
+    // Reserve everything up front, so the containers never reallocate (and briefly hold twice their size) mid-search.
+    // The remainder of the budget is left to mAvailableNodes: it holds a handle per open node, but its buckets grow by
+    // doubling and also hold stale entries, so allow for 3 handles per node
+    constexpr size_t kBytesPerNode = sizeof(Node) + sizeof(PruneInfo) + 3 * sizeof(uint32_t);
+    constexpr size_t kMinNodes = 64 * Board<W, H, L>::kMaxMoves;
+    size_t maxNodes = maxMemory / kBytesPerNode;
+    while (maxNodes > 0 && maxNodes * kBytesPerNode + NodeTable::CapacityFor(maxNodes) * sizeof(NodeTable::Entry) > maxMemory)
+        maxNodes -= maxNodes / 16 + 1;
+    if (maxNodes < kMinNodes)
     {
-        std::cerr << "[Error] Unable to insert mAvailableNodes iterator to solution into mNodeMap (should be impossible)" << std::endl;
-        exit(1);
+        std::cerr << "[Warning] Memory budget of " << maxMemory << " bytes is too small, using " << kMinNodes << " nodes instead" << std::endl;
+        maxNodes = kMinNodes;
+    }
+
+    mMaxNodes = maxNodes;
+    mNodes.reserve(mMaxNodes);
+    mPruneInfo.reserve(mMaxNodes);
+    mNodeTable.Reserve(mMaxNodes);
+    mLog << "[Info] Bounding memory to " << maxMemory / (1024 * 1024) << "MB, keeping at most " << mMaxNodes << " nodes live" << std::endl;
+}
+
+template <size_t W, size_t H, typename L>
+size_t Solver<W, H, L>::BytesUsed() const
+{
+    return mNodes.BytesUsed() + mNodeTable.BytesUsed() + mAvailableNodes.BytesUsed() + mPruneInfo.capacity() * sizeof(PruneInfo);
+}
+
+template <size_t W, size_t H, typename L>
+uint32_t Solver<W, H, L>::AddNode(const Node& node)
+{
+    uint32_t index = mNodes.Add(node);
+    if (IsMemoryBounded())
+    {
+        if (index >= mPruneInfo.size())
+            mPruneInfo.resize(index + 1);
+        mPruneInfo[index] = PruneInfo();
+        if (node.parent != Node::kNoParent)
+            mPruneInfo[node.parent].liveChildren++;
     }
+    return index;
 }
 
-template <size_t W, size_t H>
-Solution<W, H> Solver<W, H>::GetNextNode()
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::FreeNode(uint32_t index)
 {
-    Solution top = mAvailableNodes.extract(mAvailableNodes.begin()).value();
-    mNodeMap.erase(top.board);
-    mExpandedNodes.insert(top.board);
-    return top;
+    uint32_t parent = mNodes[index].parent;
+    mNodes.Free(index);
+    mPruneInfo[index].isFree = true;
+    if (parent != Node::kNoParent && --mPruneInfo[parent].liveChildren == 0 && mPruneInfo[parent].isSuperseded)
+        FreeNode(parent);
 }
 
-template <size_t W, size_t H>
-bool Solver<W, H>::UpdateBestSolution(Solution<W, H>&& candidate)
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::PushNode(uint32_t index, uint32_t cost)
 {
-    if (candidate.IsComplete(mTargets))
     {
-        bool isBetterSolution = !mBestSolution || candidate.NOfMoves() < mBestSolution->NOfMoves();
-        if (isBetterSolution)
+        STATS_TIMER(mStats.queueCycles);
+        mAvailableNodes.Push(index, cost, mNodes[index].NOfMoves());
+    }
+    if (IsMemoryBounded())
+        mPruneInfo[index].queuedCost = static_cast<uint16_t>(cost);
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::PruneNodes()
+{
+    mPeakBytesUsed = std::max(mPeakBytesUsed, BytesUsed());
+
+    // Prune a little further than needed, so the (linear) search for nodes to prune isn't repeated every iteration
+    size_t targetNodes = mMaxNodes - mMaxNodes / 16;
+    // Nodes tied with the next one to expand are kept, pruning them would only have them regenerated straight away
+    uint32_t minCost = mAvailableNodes.MinCost();
+    // Open nodes which can't be pruned because other nodes still refer to them, put back once done
+    std::vector<uint32_t> keptNodes;
+    while (mNodes.NOfLiveNodes() > targetNodes && !mAvailableNodes.empty() && mAvailableNodes.MaxCost() > minCost)
+    {
+        uint32_t cost = mAvailableNodes.MaxCost();
+        uint32_t index = mAvailableNodes.PopWorst();
+        if (mPruneInfo[index].queuedCost != cost)
+            continue;
+
+        const Node& node = mNodes[index];
+        auto isMatch = [this, &node](uint32_t other) { return mNodes[other].board == node.board; };
+        NodeTable::Entry* entry = mNodeTable.Find(node.board.Hash(), isMatch);
+        if (!entry || entry->IsClosed() || entry->Node() != index)
+            continue;
+        if (mPruneInfo[index].liveChildren > 0 || node.parent == Node::kNoParent)
         {
-            mBestSolution = candidate;
-            return true;
+            keptNodes.push_back(index);
+            continue;
         }
+
+        mNodeTable.Erase(entry);
+        mOpenNodes--;
+        mPrunedNodes++;
+        uint32_t parent = node.parent;
+        bool isParentSuperseded = mPruneInfo[parent].isSuperseded;
+        FreeNode(index);
+        // A superseded parent is freed along with its last child, the node replacing it regenerates the subtree
+        if (isParentSuperseded)
+            continue;
+
+        // The parent must be expanded again before anything costing more than the forgotten node, reopen it with
+        // that cost (or lower the cost it was already reopened with)
+        PruneInfo& parentInfo = mPruneInfo[parent];
+        parentInfo.forgottenCost = std::min(parentInfo.forgottenCost, static_cast<uint16_t>(cost));
+        const Board<W, H, L>& parentBoard = mNodes[parent].board;
+        auto isParent = [this, &parentBoard](uint32_t other) { return mNodes[other].board == parentBoard; };
+        NodeTable::Entry* parentEntry = mNodeTable.Find(parentBoard.Hash(), isParent);
+        if (parentEntry->IsClosed())
+        {
+            parentEntry->SetOpen(parent);
+            mOpenNodes++;
+            PushNode(parent, parentInfo.forgottenCost);
+        }
+        else if (parentInfo.forgottenCost < parentInfo.queuedCost)
+        {
+            PushNode(parent, parentInfo.forgottenCost);
+        }
+    }
+    for (uint32_t index : keptNodes)
+    {
+        mAvailableNodes.Push(index, mPruneInfo[index].queuedCost, mNodes[index].NOfMoves());
+    }
+
+    for (size_t swept = 0; mNodes.NOfLiveNodes() > targetNodes && swept < mNodes.size(); swept++)
+    {
+        uint32_t index = mDeadNodeCursor;
+        mDeadNodeCursor = static_cast<uint32_t>((mDeadNodeCursor + 1) % mNodes.size());
+        const Node& node = mNodes[index];
+        const PruneInfo& info = mPruneInfo[index];
+        if (info.isFree || info.liveChildren > 0 || info.isSuperseded || node.parent == Node::kNoParent)
+            continue;
+        auto isMatch = [this, &node](uint32_t other) { return mNodes[other].board == node.board; };
+        NodeTable::Entry* entry = mNodeTable.Find(node.board.Hash(), isMatch);
+        if (!entry || !entry->IsClosed() || entry->Node() != index)
+            continue;
+
+        mNodeTable.Erase(entry);
+        mPrunedNodes++;
+        FreeNode(index);
+    }
+
+    if (mNodes.NOfLiveNodes() > targetNodes && !mIsOverBudget)
+    {
+        // Only happens if the budget can't even hold the nodes on the paths to the open list, carry on regardless
+        std::cerr << "[Warning] Unable to prune below the memory budget, the search will use more memory than requested" << std::endl;
+        mIsOverBudget = true;
     }
-    return false;
-}
\ No newline at end of file
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::SaveCheckpoint(CheckpointWriter& writer) const
+{
+    // Enough of the setup to refuse checkpoints of a different puzzle or search
+    writer.WriteValue(kCheckpointMagic);
+    writer.WriteValue<uint32_t>(W);
+    writer.WriteValue<uint32_t>(H);
+    writer.WriteValue(mTargets.Mode());
+    writer.WriteValue<uint64_t>(mSymmetry.size());
+    writer.WriteValue<uint64_t>(mMaxNodes);
+
+    mNodes.Save(writer);
+    mAvailableNodes.Save(writer);
+    mNodeTable.Save(writer);
+    writer.WriteValue<uint64_t>(mOpenNodes);
+    writer.WriteValue<uint32_t>(mBestSolution.value_or(Node::kNoParent));
+    writer.WriteValue(mIteration);
+    writer.WriteValue(mStats.Snapshot());
+
+    writer.WriteVector(mPruneInfo);
+    writer.WriteValue(mDeadNodeCursor);
+    writer.WriteValue<uint64_t>(mPrunedNodes);
+    writer.WriteValue<uint64_t>(mPeakBytesUsed);
+    writer.WriteValue(mIsOverBudget);
+}
+
+template <size_t W, size_t H, typename L>
+void Solver<W, H, L>::LoadCheckpoint()
+{
+    CheckpointReader reader(mCheckpointPath);
+    bool isSameSearch = reader.ReadValue<uint64_t>() == kCheckpointMagic && reader.ReadValue<uint32_t>() == W
+        && reader.ReadValue<uint32_t>() == H && reader.ReadValue<HeuristicMode>() == mTargets.Mode()
+        && reader.ReadValue<uint64_t>() == mSymmetry.size() && reader.ReadValue<uint64_t>() == mMaxNodes;
+    if (!isSameSearch)
+    {
+        std::cerr << "[Error] Checkpoint " << mCheckpointPath << " was saved by a different search, resume with the same puzzle, --heuristic, --no-symmetry and --max-memory" << std::endl;
+        exit(1);
+    }
+
+    // The root is always node 0, and is never pruned
+    Board<W, H, L> root = mNodes[0].board;
+    mNodes.Load(reader, root.GetLayout());
+    if (mNodes.size() == 0 || !(mNodes[0].board == root))
+    {
+        std::cerr << "[Error] Checkpoint " << mCheckpointPath << " was saved while solving a different puzzle" << std::endl;
+        exit(1);
+    }
+    mAvailableNodes.Load(reader);
+    mNodeTable.Load(reader);
+    mOpenNodes = reader.ReadValue<uint64_t>();
+    uint32_t bestSolution = reader.ReadValue<uint32_t>();
+    mBestSolution = bestSolution == Node::kNoParent ? std::nullopt : std::optional<uint32_t>(bestSolution);
+    mIteration = reader.ReadValue<uint32_t>();
+    mStats.Restore(reader.ReadValue<SearchStats>());
+
+    reader.ReadVector(mPruneInfo);
+    mDeadNodeCursor = reader.ReadValue<uint32_t>();
+    mPrunedNodes = reader.ReadValue<uint64_t>();
+    mPeakBytesUsed = reader.ReadValue<uint64_t>();
+    mIsOverBudget = reader.ReadValue<bool>();
+    mLog << "[Info] Resuming from " << mCheckpointPath << " @ iteration " << mIteration << " (" << mNodes.NOfLiveNodes() << " nodes, " << mOpenNodes << " open)" << std::endl;
+}
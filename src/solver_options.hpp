@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <string>
+
+enum class HeuristicMode {
+    NEAREST_TARGET,  // Each knight is charged the distance to its nearest target, independently of the others
+    MATCHING,        // Knights of each colour are charged the cheapest assignment of distinct knights to targets
+    PATTERN_DATABASE // Knights of each colour are charged the exact cost of solving that colour alone (see PatternDatabase)
+};
+
+// Settings shared by the different solvers, each solver ignores the ones which don't apply to it
+struct SolverOptions {
+    HeuristicMode heuristic = HeuristicMode::NEAREST_TARGET;
+    // Directory pattern databases are stored in (and loaded from) when using HeuristicMode::PATTERN_DATABASE
+    std::string patternDatabaseDir = "pdb";
+    // Stores boards under a canonical representative of their mirror images/rotations when the puzzle is symmetric
+    bool useSymmetry = true;
+    // Solver: don't log progress to std::cout, e.g. when solving many puzzles at once
+    bool isQuiet = false;
+
+    // Solver: file a StatsReporter appends the search's counters to as JSON lines every statsIntervalMs, none if empty
+    std::string statsPath;
+    uint32_t statsIntervalMs = 1000;
+
+    // Solver: file the search state is saved to every checkpointIntervalSeconds (and when interrupted), none if
+    // empty. With resume, the search carries on from the checkpoint already in that file
+    std::string checkpointPath;
+    uint32_t checkpointIntervalSeconds = 600;
+    bool resume = false;
+
+    // Solver: bytes the open and closed lists may use, 0 means unlimited. Past this, the worst open nodes are forgotten
+    // and regenerated later if needed (see Solver::PruneNodes)
+    size_t maxMemory = 0;
+    // Solver: partial expansion (PEA*), expanding a node only generates its children with the f-cost it was queued
+    // with, and the node is queued again with the next larger f-cost of its children. Not combined with maxMemory
+    bool usePartialExpansion = false;
+
+    // IdaSolver: number of transposition table entries (rounded down to a power of 2), 0 disables the table
+    size_t transpositionTableEntries = size_t{1} << 24;
+
+    // ParallelSolver and BatchSolver: number of worker threads
+    uint32_t nOfThreads = std::thread::hardware_concurrency();
+
+    // ExternalSolver: directory the bucket files are stored in, and the number of records sorted in memory at once
+    std::string externalDir = "external";
+    size_t externalSortRecords = size_t{1} << 22;
+};
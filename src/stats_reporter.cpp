@@ -0,0 +1,68 @@
+#include "stats_reporter.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+StatsReporter::StatsReporter(const SearchCounters& counters, const std::string& path, std::chrono::milliseconds interval)
+    : mCounters(counters), mOut(path), mInterval(interval), mStart(std::chrono::steady_clock::now()), mLastLine(mStart)
+{
+    if (!mOut)
+    {
+        std::cerr << "[Error] Unable to open " << path << " to write search stats to" << std::endl;
+        exit(1);
+    }
+    mThread = std::thread(&StatsReporter::Run, this);
+}
+
+StatsReporter::~StatsReporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mStopped.notify_one();
+    mThread.join();
+    WriteLine(true);
+}
+
+void StatsReporter::Run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopped.wait_for(lock, mInterval, [this] { return mIsStopping; }))
+    {
+        WriteLine(false);
+    }
+}
+
+void StatsReporter::WriteLine(bool isFinal)
+{
+    SearchStats stats = mCounters.Snapshot();
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - mStart).count();
+    double sinceLastLine = std::chrono::duration<double>(now - mLastLine).count();
+    double expandedPerSecond = sinceLastLine > 0 ? static_cast<double>(stats.expandedNodes - mLastExpandedNodes) / sinceLastLine : 0.0;
+    mLastLine = now;
+    mLastExpandedNodes = stats.expandedNodes;
+
+    mOut << "{\"elapsedSeconds\":" << elapsed << ",\"final\":" << (isFinal ? "true" : "false")
+         << ",\"expandedNodes\":" << stats.expandedNodes << ",\"generatedNodes\":" << stats.generatedNodes
+         << ",\"filteredNodes\":" << stats.filteredNodes << ",\"openNodes\":" << stats.openNodes
+         << ",\"expandedPerSecond\":" << expandedPerSecond;
+#ifdef STATS
+    mOut << ",\"closedSetHits\":" << stats.closedSetHits << ",\"openSetReplacements\":" << stats.openSetReplacements
+         << ",\"cycles\":{\"heuristic\":" << stats.heuristicCycles << ",\"hashing\":" << stats.hashingCycles
+         << ",\"moveGeneration\":" << stats.moveGenerationCycles << ",\"queue\":" << stats.queueCycles << '}'
+         << ",\"expandedPerCost\":{";
+    bool isFirst = true;
+    for (size_t cost = 0; cost < kMaxStatsCostLayers; cost++)
+    {
+        if (!stats.expandedPerCost[cost])
+            continue;
+        mOut << (isFirst ? "" : ",") << '"' << cost << "\":" << stats.expandedPerCost[cost];
+        isFirst = false;
+    }
+    mOut << '}';
+#endif
+    // Flushed so the file can be followed while the search runs
+    mOut << '}' << std::endl;
+}
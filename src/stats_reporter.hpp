@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "search_stats.hpp"
+
+// Background thread appending a snapshot of a search's counters to a file as a JSON line every interval, plus a final
+// line when destroyed. The search thread only ever updates its counters, so reporting costs it nothing.
+class StatsReporter {
+public:
+    StatsReporter(const SearchCounters& counters, const std::string& path, std::chrono::milliseconds interval);
+    ~StatsReporter();
+    StatsReporter(const StatsReporter&) = delete;
+    StatsReporter& operator=(const StatsReporter&) = delete;
+
+private:
+    void Run();
+    void WriteLine(bool isFinal);
+
+    const SearchCounters& mCounters;
+    std::ofstream mOut;
+    std::chrono::milliseconds mInterval;
+    std::chrono::steady_clock::time_point mStart;
+    std::chrono::steady_clock::time_point mLastLine;
+    uint64_t mLastExpandedNodes = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mStopped;
+    bool mIsStopping = false;
+    std::thread mThread;
+};
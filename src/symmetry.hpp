@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include "common.hpp"
+#include "board.hpp"
+#include "board_layout.hpp"
+#include "targets.hpp"
+
+// Symmetry group of a puzzle: the reflections and rotations of the board which map every BLOCKED tile onto a BLOCKED
+// tile and every target onto a target of the same colour. Knight moves are invariant under all of them, so a board
+// and its image are exactly as far from being solved, and solvers only need to store one of them (the canonical
+// representative). Transforms are referred to by their index, 0 being the identity.
+template <size_t Width, size_t Height>
+class Symmetry {
+public:
+    static constexpr uint8_t kIdentity = 0;
+
+    // Only the identity is kept if enabled is false. The number of symmetries found is reported to log
+    Symmetry(const BoardLayout<Width, Height>& layout, const Targets<Width, Height>& targets, bool enabled = true, std::ostream& log = std::cout);
+
+    size_t size() const { return mTransforms.size(); }
+
+    // Replaces board by its image with the smallest packed board, returning the index of the transform applied
+    template <typename LayoutPolicy>
+    uint8_t Canonicalise(Board<Width, Height, LayoutPolicy>& board) const;
+
+    template <typename LayoutPolicy>
+    Board<Width, Height, LayoutPolicy> Apply(uint8_t transform, const Board<Width, Height, LayoutPolicy>& board) const { return board.PermuteSlots(mTransforms[transform].slotMap); }
+    Move Apply(uint8_t transform, const Move& move) const { return {Apply(transform, move.start), Apply(transform, move.end)}; }
+    BoardPos Apply(uint8_t transform, const BoardPos& tile) const;
+
+    uint8_t Inverse(uint8_t transform) const { return mInverses[transform]; }
+    // Transform equivalent to applying inner, then outer
+    uint8_t Compose(uint8_t outer, uint8_t inner) const { return mCompositions[outer * size() + inner]; }
+
+private:
+    static constexpr size_t kCells = Width * Height;
+    using CellMap = std::array<uint8_t, kCells>;
+
+    struct Transform {
+        CellMap cellMap;                     // cell index -> cell index of its image
+        std::array<uint8_t, kCells> slotMap; // slot index -> slot index of its image
+    };
+
+    static std::vector<CellMap> CandidateTransforms();
+
+    std::vector<Transform> mTransforms;
+    std::vector<uint8_t> mInverses;
+    std::vector<uint8_t> mCompositions;
+};
+
+template <size_t W, size_t H>
+Symmetry<W, H>::Symmetry(const BoardLayout<W, H>& layout, const Targets<W, H>& targets, bool enabled, std::ostream& log)
+{
+    for (const CellMap& cellMap : CandidateTransforms())
+    {
+        if (!enabled && !mTransforms.empty())
+            break;
+
+        bool isSymmetry = true;
+        for (size_t cell = 0; cell < kCells; cell++)
+        {
+            isSymmetry &= layout.blocked[cell] == layout.blocked[cellMap[cell]];
+        }
+        for (const auto& [target, tiles] : targets)
+        {
+            std::vector<uint8_t> cells;
+            std::vector<uint8_t> images;
+            for (const auto& tile : tiles)
+            {
+                uint8_t cell = static_cast<uint8_t>(BoardLayout<W, H>::CellIndex(tile.x, tile.y));
+                cells.push_back(cell);
+                images.push_back(cellMap[cell]);
+            }
+            std::sort(cells.begin(), cells.end());
+            std::sort(images.begin(), images.end());
+            isSymmetry &= cells == images;
+        }
+        if (!isSymmetry)
+            continue;
+
+        Transform transform{cellMap, {}};
+        for (size_t slot = 0; slot < layout.nOfSlots; slot++)
+        {
+            transform.slotMap[slot] = static_cast<uint8_t>(layout.slotOf[cellMap[layout.cellOf[slot]]]);
+        }
+        mTransforms.push_back(transform);
+    }
+
+    // The transforms found form a group, so compositions and inverses can be looked up by comparing cell maps
+    auto indexOf = [this](const CellMap& cellMap) {
+        auto it = std::find_if(mTransforms.begin(), mTransforms.end(), [&cellMap](const Transform& t) { return t.cellMap == cellMap; });
+        return static_cast<uint8_t>(it - mTransforms.begin());
+    };
+    mCompositions.resize(size() * size());
+    mInverses.resize(size());
+    for (size_t outer = 0; outer < size(); outer++)
+    {
+        for (size_t inner = 0; inner < size(); inner++)
+        {
+            CellMap composed;
+            for (size_t cell = 0; cell < kCells; cell++)
+            {
+                composed[cell] = mTransforms[outer].cellMap[mTransforms[inner].cellMap[cell]];
+            }
+            uint8_t index = indexOf(composed);
+            mCompositions[outer * size() + inner] = index;
+            if (index == kIdentity)
+                mInverses[outer] = static_cast<uint8_t>(inner);
+        }
+    }
+
+    if (size() > 1)
+        log << "[Info] Puzzle has " << size() << " symmetries, storing boards under their canonical representative" << std::endl;
+}
+
+template <size_t W, size_t H>
+std::vector<typename Symmetry<W, H>::CellMap> Symmetry<W, H>::CandidateTransforms()
+{
+    // Reflections and rotations of a rectangle, plus those swapping the axes when the board is square. The identity
+    // comes first
+    std::vector<std::pair<int, int>> axes = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+    std::vector<CellMap> candidates;
+    for (bool transpose : {false, true})
+    {
+        if (transpose && W != H)
+            break;
+
+        for (const auto& [flipX, flipY] : axes)
+        {
+            CellMap cellMap;
+            for (size_t y = 0; y < H; y++)
+            {
+                for (size_t x = 0; x < W; x++)
+                {
+                    size_t u = transpose ? y : x;
+                    size_t v = transpose ? x : y;
+                    u = flipX < 0 ? W - 1 - u : u;
+                    v = flipY < 0 ? H - 1 - v : v;
+                    cellMap[y * W + x] = static_cast<uint8_t>(v * W + u);
+                }
+            }
+            candidates.push_back(cellMap);
+        }
+    }
+    return candidates;
+}
+
+template <size_t W, size_t H>
+template <typename L>
+uint8_t Symmetry<W, H>::Canonicalise(Board<W, H, L>& board) const
+{
+    uint8_t best = kIdentity;
+    Board<W, H, L> bestBoard = board;
+    for (size_t transform = 1; transform < size(); transform++)
+    {
+        Board<W, H, L> image = Apply(static_cast<uint8_t>(transform), board);
+        if (image.GetPackedBoard() < bestBoard.GetPackedBoard())
+        {
+            best = static_cast<uint8_t>(transform);
+            bestBoard = image;
+        }
+    }
+    board = bestBoard;
+    return best;
+}
+
+template <size_t W, size_t H>
+BoardPos Symmetry<W, H>::Apply(uint8_t transform, const BoardPos& tile) const
+{
+    uint8_t cell = mTransforms[transform].cellMap[BoardLayout<W, H>::CellIndex(tile.x, tile.y)];
+    return {static_cast<int8_t>(cell % W), static_cast<int8_t>(cell / W)};
+}
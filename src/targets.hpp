@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <memory>
+#include <string>
+#include <optional>
+
+#include "common.hpp"
+#include "board_layout.hpp"
+#include "pattern_database.hpp"
+#include "solver_options.hpp"
+
+// Target positions of a puzzle, along with tables precomputed from them to speed up heuristic evaluation
+template <size_t Width, size_t Height>
+class Targets {
+public:
+    using TargetMap = std::unordered_map<Target, std::vector<BoardPos>>;
+    static constexpr uint8_t kUnreachable = UINT8_MAX;
+
+    template <typename LayoutPolicy>
+    Targets(TargetMap&& positions, const Board<Width, Height, LayoutPolicy>& initialBoard, const SolverOptions& options = {});
+
+    HeuristicMode Mode() const { return mMode; }
+    const std::vector<BoardPos>& at(Target target) const { return mPositions.at(target); }
+    size_t NOfTargets(Target target) const { return mTargetDistances[static_cast<size_t>(target)].size(); }
+    TargetMap::const_iterator begin() const { return mPositions.begin(); }
+    TargetMap::const_iterator end() const { return mPositions.end(); }
+
+    // Fewest knight moves from tile to the nearest target of the given colour, taking BLOCKED tiles and the edges of
+    // the board into account (but not other knights, which may move out of the way)
+    uint8_t MinimumMovesToTarget(Target target, const BoardPos& tile) const { return mDistances[static_cast<size_t>(target)][CellIndex(tile)]; }
+    // Fewest knight moves from tile to a specific target (indexed as in at(target)), under the same assumptions
+    uint8_t MinimumMovesToTarget(Target target, size_t targetIndex, const BoardPos& tile) const { return mTargetDistances[static_cast<size_t>(target)][targetIndex][CellIndex(tile)]; }
+    bool IsTarget(const BoardPos& tile) const { return mIsTarget[CellIndex(tile)]; }
+
+    // Exact number of moves of knights of a colour needed to fill its targets if every other knight could move for
+    // free, or std::nullopt if there is no pattern database for that colour
+    template <typename LayoutPolicy>
+    std::optional<uint32_t> GetPatternCost(Target target, const Board<Width, Height, LayoutPolicy>& board) const;
+
+    static constexpr size_t kNOfTargets = static_cast<size_t>(Target::RED) + 1;
+
+private:
+    static constexpr size_t kCells = Width * Height;
+    using DistanceTable = std::array<uint8_t, kCells>;
+
+    static size_t CellIndex(const BoardPos& tile) { return BoardLayout<Width, Height>::CellIndex(tile.x, tile.y); }
+
+    // Multi-source BFS from sources over the knight-move graph of non-BLOCKED tiles
+    static DistanceTable ComputeDistances(const std::vector<BoardPos>& sources, const BoardLayout<Width, Height>& layout);
+    template <typename LayoutPolicy>
+    void LoadPatternDatabases(const Board<Width, Height, LayoutPolicy>& initialBoard, const std::string& directory);
+
+    TargetMap mPositions;
+    HeuristicMode mMode;
+    std::array<DistanceTable, kNOfTargets> mDistances;
+    std::array<std::vector<DistanceTable>, kNOfTargets> mTargetDistances;
+    std::array<bool, kCells> mIsTarget;
+    std::array<std::unique_ptr<PatternDatabase>, kNOfTargets> mPatternDatabases;
+};
+
+template <size_t W, size_t H>
+template <typename L>
+Targets<W, H>::Targets(TargetMap&& positions, const Board<W, H, L>& initialBoard, const SolverOptions& options)
+    : mPositions(std::move(positions)), mMode(options.heuristic), mDistances{}, mTargetDistances{}, mIsTarget{}
+{
+    const BoardLayout<W, H>& layout = initialBoard.GetLayout();
+    for (const auto& [target, tiles] : mPositions)
+    {
+        if (tiles.empty())
+            continue;
+
+        for (const auto& tile : tiles)
+        {
+            // No knight can ever reach a BLOCKED target, and the tables below only cover mutable tiles
+            if (layout.slotOf[CellIndex(tile)] == BoardLayout<W, H>::kNoSlot)
+            {
+                std::cerr << "[Error] Target " << static_cast<char>('a' + tile.x) << tile.y + 1 << " is on a BLOCKED tile, problem has no solution" << std::endl;
+                exit(1);
+            }
+        }
+        // Nothing needs to reach a target of a colour without targets, so its distances are left at 0
+        mDistances[static_cast<size_t>(target)] = ComputeDistances(tiles, layout);
+        for (const auto& tile : tiles)
+        {
+            mIsTarget[CellIndex(tile)] = true;
+            mTargetDistances[static_cast<size_t>(target)].push_back(ComputeDistances({tile}, layout));
+        }
+    }
+
+    if (mMode == HeuristicMode::PATTERN_DATABASE)
+        LoadPatternDatabases(initialBoard, options.patternDatabaseDir);
+}
+
+template <size_t W, size_t H>
+template <typename L>
+void Targets<W, H>::LoadPatternDatabases(const Board<W, H, L>& initialBoard, const std::string& directory)
+{
+    const BoardLayout<W, H>& layout = initialBoard.GetLayout();
+    PatternDatabase::Abstraction abstraction;
+    abstraction.slotNeighbours.resize(layout.nOfSlots);
+    for (size_t slot = 0; slot < layout.nOfSlots; slot++)
+    {
+        const auto& neighbours = layout.slotNeighbours[slot];
+        abstraction.slotNeighbours[slot].assign(neighbours.begin(), neighbours.begin() + layout.nOfSlotNeighbours[slot]);
+    }
+
+    for (const auto& [target, tiles] : mPositions)
+    {
+        abstraction.targetSlots.clear();
+        for (const auto& tile : tiles)
+        {
+            abstraction.targetSlots.push_back(static_cast<uint8_t>(layout.slotOf[CellIndex(tile)]));
+        }
+        abstraction.nOfKnights = 0;
+        abstraction.nOfOthers = 0;
+        initialBoard.ForEachKnight(target, [&abstraction](size_t, bool isPatternKnight) {
+            (isPatternKnight ? abstraction.nOfKnights : abstraction.nOfOthers)++;
+        });
+
+        std::string name = std::to_string(W) + 'x' + std::to_string(H) + '_' + targetCharMapping.toValue(target);
+        mPatternDatabases[static_cast<size_t>(target)] = PatternDatabase::LoadOrBuild(directory, name, abstraction);
+    }
+}
+
+template <size_t W, size_t H>
+template <typename L>
+std::optional<uint32_t> Targets<W, H>::GetPatternCost(Target target, const Board<W, H, L>& board) const
+{
+    const auto& database = mPatternDatabases[static_cast<size_t>(target)];
+    if (!database)
+        return {};
+
+    uint64_t patternRank = 0;
+    uint64_t otherRank = 0;
+    uint32_t nOfKnights = 0;
+    uint32_t nOfOthers = 0;
+    board.ForEachKnight(target, [&](size_t slot, bool isPatternKnight) {
+        if (isPatternKnight)
+            patternRank += database->RankTerm(slot, nOfKnights++);
+        else
+            otherRank += database->RankTerm(slot - nOfKnights, nOfOthers++);
+    });
+    return database->Lookup(patternRank, otherRank);
+}
+
+template <size_t W, size_t H>
+typename Targets<W, H>::DistanceTable Targets<W, H>::ComputeDistances(const std::vector<BoardPos>& sources, const BoardLayout<W, H>& layout)
+{
+    constexpr const KnightNeighbours<W, H>& neighbours = kKnightNeighbours<W, H>;
+    DistanceTable distances;
+    distances.fill(kUnreachable);
+    std::queue<size_t> frontier;
+    for (const auto& tile : sources)
+    {
+        distances[CellIndex(tile)] = 0;
+        frontier.push(CellIndex(tile));
+    }
+
+    while (!frontier.empty())
+    {
+        size_t curr = frontier.front();
+        frontier.pop();
+        for (size_t i = 0; i < neighbours.count[curr]; i++)
+        {
+            size_t next = neighbours.cells[curr][i];
+            if (layout.blocked[next] || distances[next] != kUnreachable)
+                continue;
+
+            distances[next] = static_cast<uint8_t>(distances[curr] + 1);
+            frontier.push(next);
+        }
+    }
+    return distances;
+}
@@ -0,0 +1,123 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+namespace {
+// Index of the worker running on the current thread, so tasks submitted by a task stay on that worker
+thread_local size_t currentWorker = SIZE_MAX;
+thread_local const WorkStealingPool* currentWorkerPool = nullptr;
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t nOfThreads)
+{
+    size_t nOfWorkers = std::max<uint32_t>(nOfThreads, 1);
+    for (size_t i = 0; i < nOfWorkers; i++)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < nOfWorkers; i++)
+    {
+        mThreads.emplace_back(&WorkStealingPool::Run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    WaitForPending(0);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mTaskQueued.notify_all();
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(std::function<void()> task)
+{
+    Worker& queue = currentWorkerPool == this ? *mWorkers[currentWorker] : mInjected;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueued++;
+        mPending++;
+    }
+    mTaskQueued.notify_one();
+}
+
+void WorkStealingPool::WaitForPending(size_t maxPending)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTaskFinished.wait(lock, [this, maxPending] { return mPending <= maxPending; });
+}
+
+bool WorkStealingPool::TakeTask(size_t index, std::function<void()>& task)
+{
+    {
+        Worker& own = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mInjected.mutex);
+        if (!mInjected.tasks.empty())
+        {
+            task = std::move(mInjected.tasks.front());
+            mInjected.tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < mWorkers.size(); offset++)
+    {
+        Worker& victim = *mWorkers[(index + offset) % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::Run(size_t index)
+{
+    currentWorker = index;
+    currentWorkerPool = this;
+    std::function<void()> task;
+    while (true)
+    {
+        {
+            // mQueued counts tasks in the deques (including mInjected), so a worker only sleeps once there is nothing left to take
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskQueued.wait(lock, [this] { return mQueued > 0 || mIsStopping; });
+            if (mQueued == 0)
+                return;
+        }
+        if (!TakeTask(index, task))
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueued--;
+        }
+
+        task();
+        task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPending--;
+        }
+        mTaskFinished.notify_all();
+    }
+}
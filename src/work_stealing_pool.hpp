@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads, each with its own deque of tasks. Workers run the tasks they submitted themselves newest
+// first, then the tasks submitted from outside the pool in the order they came in, and once out of work steal the
+// oldest task of another worker, so long tasks queued behind each other on one worker get spread over the idle ones.
+// Tasks are expected to be coarse (e.g. a whole puzzle), so each deque is simply guarded by a mutex
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(uint32_t nOfThreads);
+    // Runs the tasks still queued, then joins the workers
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queues task on the calling worker's deque, or on the shared injection queue when called from another thread
+    void Submit(std::function<void()> task);
+    // Blocks until at most maxPending submitted tasks haven't finished, e.g. to bound how far a producer gets ahead
+    void WaitForPending(size_t maxPending = 0);
+
+    size_t size() const { return mThreads.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void Run(size_t index);
+    // Pops the newest task of worker index, or the oldest injected task, or steals the oldest task of another worker
+    bool TakeTask(size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+    // Tasks submitted from outside the pool, run first in first out
+    Worker mInjected;
+
+    std::mutex mMutex;
+    std::condition_variable mTaskQueued;
+    std::condition_variable mTaskFinished;
+    size_t mQueued = 0;  // Tasks sitting in a deque
+    size_t mPending = 0; // Tasks submitted which haven't finished
+    bool mIsStopping = false;
+};